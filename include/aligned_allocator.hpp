@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+namespace MpiWrapper::Utils {
+
+///
+///@brief Cache line size used for the alignment and padding of the local data blocks
+///
+constexpr size_t cache_line_size = 64;
+
+///
+///@brief Allocator returning memory aligned to the given boundary, e.g. to avoid false sharing
+/// and misaligned vector loads.
+///
+///@tparam T value type
+///@tparam Alignment alignment in bytes, a power of two
+///
+template <class T, size_t Alignment = cache_line_size> struct AlignedAllocator {
+
+    static_assert((Alignment & (Alignment - 1)) == 0, "Alignment has to be a power of two.");
+
+    using value_type = T;
+
+    template <class U> struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+    AlignedAllocator() = default;
+
+    template <class U> constexpr AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T* p, size_t) noexcept { ::operator delete(p, std::align_val_t(Alignment)); }
+
+    template <class U> bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept {
+        return true;
+    }
+
+    template <class U> bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept {
+        return false;
+    }
+};
+
+///
+///@brief Rounds n up to the next multiple of m
+///
+///@param n the value to round
+///@param m the multiple
+///@return size_t the rounded value
+///
+constexpr size_t round_up(size_t n, size_t m) { return ((n + m - 1) / m) * m; }
+
+} // namespace MpiWrapper::Utils
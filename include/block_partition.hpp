@@ -0,0 +1,33 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+namespace MpiWrapper::Utils {
+
+///
+///@brief Size of the block idx when n elements are split into parts nearly equal blocks, the
+/// first n % parts blocks get one extra element.
+///
+///@param n total number of elements
+///@param parts number of blocks
+///@param idx index of the block
+///@return size_t number of elements in the block
+///
+constexpr size_t block_size(size_t n, size_t parts, size_t idx) {
+    return n / parts + (idx < n % parts ? 1 : 0);
+}
+
+///
+///@brief Offset of the first element of the block idx, see block_size()
+///
+///@param n total number of elements
+///@param parts number of blocks
+///@param idx index of the block
+///@return size_t index of the first element of the block
+///
+constexpr size_t block_offset(size_t n, size_t parts, size_t idx) {
+    return idx * (n / parts) + std::min(idx, n % parts);
+}
+
+} // namespace MpiWrapper::Utils
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace MpiWrapper::Utils {
+
+///
+///@brief Transposes the bytes of n elements of element_size bytes, byte b of element i goes to
+/// out[b * n + i]. The exponent and high mantissa bytes of smooth floating-point data are then
+/// grouped into long repetitive runs which the LZ coder compresses well.
+///
+///@param in the elements
+///@param n number of elements
+///@param element_size size of one element in bytes
+///@param out output buffer of n * element_size bytes
+///
+inline void
+byte_shuffle(const unsigned char* in, size_t n, size_t element_size, unsigned char* out) {
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t b = 0; b < element_size; ++b) { out[b * n + i] = in[i * element_size + b]; }
+    }
+}
+
+///
+///@brief Inverse of byte_shuffle()
+///
+///@param in the shuffled bytes
+///@param n number of elements
+///@param element_size size of one element in bytes
+///@param out output buffer of n * element_size bytes
+///
+inline void
+byte_unshuffle(const unsigned char* in, size_t n, size_t element_size, unsigned char* out) {
+    for (size_t b = 0; b < element_size; ++b) {
+        for (size_t i = 0; i < n; ++i) { out[i * element_size + b] = in[b * n + i]; }
+    }
+}
+
+namespace detail {
+
+constexpr size_t lz_min_match  = 4;
+constexpr size_t lz_max_offset = 65535;
+constexpr size_t lz_hash_bits  = 14;
+
+inline uint32_t lz_read32(const unsigned char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint32_t lz_hash(uint32_t v) { return (v * 2654435761u) >> (32 - lz_hash_bits); }
+
+template <class Buffer> void lz_put_length(Buffer& out, size_t length) {
+    while (length >= 255) {
+        out.push_back(255);
+        length -= 255;
+    }
+    out.push_back(static_cast<unsigned char>(length));
+}
+
+inline size_t lz_get_length(const unsigned char*& ip, const unsigned char* end) {
+    size_t  length = 0;
+    uint8_t b      = 255;
+    while (b == 255) {
+        if (ip == end) { throw std::runtime_error("Corrupt compressed data."); }
+        b = *ip++;
+        length += b;
+    }
+    return length;
+}
+
+template <class Buffer>
+void lz_put_sequence(Buffer&              out,
+                     const unsigned char* literals,
+                     size_t               n_literals,
+                     size_t               offset,
+                     size_t               match) {
+    const size_t lit_code   = n_literals < 15 ? n_literals : 15;
+    const size_t match_code =
+        match == 0 ? 0 : (match - lz_min_match < 15 ? match - lz_min_match : 15);
+    out.push_back(static_cast<unsigned char>(lit_code << 4 | match_code));
+    if (lit_code == 15) { lz_put_length(out, n_literals - 15); }
+    out.insert(out.end(), literals, literals + n_literals);
+    if (match == 0) { return; }
+    out.push_back(static_cast<unsigned char>(offset & 0xff));
+    out.push_back(static_cast<unsigned char>(offset >> 8));
+    if (match_code == 15) { lz_put_length(out, match - lz_min_match - 15); }
+}
+
+} // namespace detail
+
+///
+///@brief Compresses bytes with a greedy LZ77 coder in the format of an LZ4 block: sequences of
+/// a token (literal and match length nibbles), the literals, a 16-bit offset and extra length
+/// bytes. Matches are found with a single-entry hash table of 4-byte prefixes, the search skips
+/// faster through incompressible data.
+///
+///@param in the data
+///@param n number of bytes
+///@param out vector of bytes, the compressed data is appended
+///@param table vector of size_t used as the hash table, resized and cleared here so that callers
+/// compressing many messages can keep it instead of allocating it per call
+///
+template <class Buffer, class Table>
+void lz_compress(const unsigned char* in, size_t n, Buffer& out, Table& table) {
+    using namespace detail;
+
+    table.resize(size_t(1) << lz_hash_bits);
+    std::fill(table.begin(), table.end(), size_t(0)); // position + 1, 0 = empty
+    size_t anchor = 0;
+    size_t i      = 0;
+    while (i + lz_min_match <= n) {
+        const uint32_t seq  = lz_read32(in + i);
+        const uint32_t h    = lz_hash(seq);
+        const size_t   cand = table[h];
+        table[h]            = i + 1;
+
+        if (cand != 0 && i - (cand - 1) <= lz_max_offset && lz_read32(in + cand - 1) == seq) {
+            const size_t m     = cand - 1;
+            size_t       match = lz_min_match;
+            while (i + match < n && in[m + match] == in[i + match]) { ++match; }
+            lz_put_sequence(out, in + anchor, i - anchor, i - m, match);
+            i += match;
+            anchor = i;
+        } else {
+            i += 1 + ((i - anchor) >> 6);
+        }
+    }
+    lz_put_sequence(out, in + anchor, n - anchor, 0, 0);
+}
+
+///
+///@brief Compresses bytes with lz_compress() and a temporary hash table
+///
+template <class Buffer> void lz_compress(const unsigned char* in, size_t n, Buffer& out) {
+    std::vector<size_t> table;
+    lz_compress(in, n, out, table);
+}
+
+///
+///@brief Decompresses data of lz_compress(), throws std::runtime_error if the data is corrupt or
+/// does not decompress to exactly n bytes
+///
+///@param in the compressed data
+///@param n_in number of compressed bytes
+///@param out output buffer
+///@param n number of decompressed bytes
+///
+inline void lz_decompress(const unsigned char* in, size_t n_in, unsigned char* out, size_t n) {
+    using namespace detail;
+
+    const unsigned char* ip  = in;
+    const unsigned char* end = in + n_in;
+    size_t               op  = 0;
+    while (ip < end) {
+        const unsigned token = *ip++;
+
+        size_t n_literals = token >> 4;
+        if (n_literals == 15) { n_literals += lz_get_length(ip, end); }
+        if (n_literals > size_t(end - ip) || n_literals > n - op) {
+            throw std::runtime_error("Corrupt compressed data.");
+        }
+        std::memcpy(out + op, ip, n_literals);
+        ip += n_literals;
+        op += n_literals;
+        if (ip == end) { break; }
+
+        if (end - ip < 2) { throw std::runtime_error("Corrupt compressed data."); }
+        const size_t offset = size_t(ip[0]) | size_t(ip[1]) << 8;
+        ip += 2;
+        size_t match = (token & 15u) + lz_min_match;
+        if ((token & 15u) == 15) { match += lz_get_length(ip, end); }
+        if (offset == 0 || offset > op || match > n - op) {
+            throw std::runtime_error("Corrupt compressed data.");
+        }
+        // byte by byte, the source may overlap the destination
+        for (size_t k = 0; k < match; ++k, ++op) { out[op] = out[op - offset]; }
+    }
+    if (op != n) { throw std::runtime_error("Corrupt compressed data."); }
+}
+
+///
+///@brief Error-bounded quantization of floating-point data: every value is rounded to a
+/// multiple of 2 * error_bound, and the differences of consecutive multiples are stored
+/// zigzag-encoded, so that smooth data turns into small integers with many zero high bytes.
+///
+///@param in the values
+///@param n number of values
+///@param error_bound maximum absolute error, > 0
+///@param out output buffer of n integers
+///@return true on success
+///@return false if a value is not finite or out of the integer range, out is undefined then
+///
+template <class T>
+bool quantize(const T* in, size_t n, double error_bound, uint64_t* out) {
+    static_assert(std::is_floating_point_v<T>, "Quantization of floating-point types only.");
+    const double scale    = 1.0 / (2.0 * error_bound);
+    int64_t      previous = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const double q = std::nearbyint(double(in[i]) * scale);
+        if (!(std::fabs(q) < 2.0e18)) { return false; } // also rejects nan
+        const int64_t current = int64_t(q);
+        const int64_t delta   = current - previous;
+        previous              = current;
+        out[i] = (uint64_t(delta) << 1) ^ uint64_t(delta >> 63);
+    }
+    return true;
+}
+
+///
+///@brief Inverse of quantize(), the results differ from the original values by at most
+/// error_bound (plus the rounding error of T)
+///
+///@param in the quantized values
+///@param n number of values
+///@param error_bound the error bound used for quantization
+///@param out output buffer of n values
+///
+template <class T>
+void dequantize(const uint64_t* in, size_t n, double error_bound, T* out) {
+    static_assert(std::is_floating_point_v<T>, "Quantization of floating-point types only.");
+    const double step    = 2.0 * error_bound;
+    int64_t      current = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const int64_t delta = int64_t(in[i] >> 1) ^ -int64_t(in[i] & 1);
+        current += delta;
+        out[i] = T(double(current) * step);
+    }
+}
+
+} // namespace MpiWrapper::Utils
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <string>
+
+#include "mpi_derived_datatype.hpp"
+#include "mpi_distributed_array.hpp"
+#include "mpi_file.hpp"
+#include "mpi_native_datatypes.hpp"
+
+namespace MpiWrapper {
+
+///
+///@brief Creates the filetype of the local block of arr in the global array stored in C order
+///
+template <class T, size_t N> DerivedDatatype array_filetype(const DistributedArray<T, N>& arr) {
+    return DerivedDatatype::subarray(
+        arr.global_extents(), arr.local_extents(), arr.local_offsets(), MpiDatatype<T>());
+}
+
+///
+///@brief Writes the interior of a distributed array as one global C-order array at offset disp
+/// of a file, collective over the communicator of the file. Every process sets a view of its
+/// block and the data is written with a single MPI_File_write_all, so the MPI-IO layer can
+/// aggregate the pieces into large contiguous writes (see FileHints::cb_nodes).
+///
+///@param file file opened for writing on the communicator of arr
+///@param arr the array
+///@param disp offset of the array in bytes, e.g. after a header, default = 0
+///
+template <class T, size_t N>
+void write_array(File& file, const DistributedArray<T, N>& arr, MPI_Offset disp = 0) {
+    auto filetype = array_filetype(arr);
+    auto memtype  = arr.interior_datatype();
+    file.set_view(disp, MpiDatatype<T>(), filetype);
+    file.write_all(arr.data(), 1, memtype);
+}
+
+///
+///@brief Reads the interior of a distributed array from a global C-order array at offset disp
+/// of a file and exchanges the ghosts, collective over the communicator of the file. The
+/// decomposition of arr does not have to match the one used for writing.
+///
+///@param file file opened for reading on the communicator of arr
+///@param arr the array, its global extents have to match the stored array
+///@param disp offset of the array in bytes, default = 0
+///
+template <class T, size_t N>
+void read_array(File& file, DistributedArray<T, N>& arr, MPI_Offset disp = 0) {
+    auto filetype = array_filetype(arr);
+    auto memtype  = arr.interior_datatype();
+    file.set_view(disp, MpiDatatype<T>(), filetype);
+    file.read_all(arr.data(), 1, memtype);
+    arr.exchange_ghosts();
+}
+
+///
+///@brief Creates a file and writes a distributed array to it, see write_array(file, arr, disp)
+///
+///@param path the file name
+///@param arr the array
+///@param hints tuning hints, default = none
+///
+template <class T, size_t N>
+void write_array(const std::string&            path,
+                 const DistributedArray<T, N>& arr,
+                 const FileHints&              hints = FileHints()) {
+    auto file = File::create(arr.get_communicator(), path, hints);
+    write_array(file, arr);
+}
+
+///
+///@brief Reads a distributed array from a file, see read_array(file, arr, disp)
+///
+///@param path the file name
+///@param arr the array
+///@param hints tuning hints, default = none
+///
+template <class T, size_t N>
+void read_array(const std::string&      path,
+                DistributedArray<T, N>& arr,
+                const FileHints&        hints = FileHints()) {
+    auto file = File::open(arr.get_communicator(), path, hints);
+    read_array(file, arr);
+}
+
+} // namespace MpiWrapper
@@ -0,0 +1,327 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include <mpi.h>
+
+#include "aligned_allocator.hpp"
+#include "mpi_functions.hpp"
+
+namespace MpiWrapper {
+
+///
+///@brief Process-wide pool of communication buffers allocated with MPI_Alloc_mem, so that the
+/// memory stays registered with the network and is not faulted in again by every exchange.
+/// Requests are rounded up to power-of-two size classes from 256 bytes, freed blocks are kept
+/// in a small per-thread cache and behind it in a shared cache per class. Buffers are cache
+/// line aligned.
+///
+/// The cached blocks are released when MPI_Finalize deletes an attribute of MPI_COMM_SELF.
+/// Before MPI_Init and after MPI_Finalize the pool falls back to the heap. Blocks of
+/// MPI_Alloc_mem still in use at MPI_Finalize can not be freed any more, they are dropped (leaked)
+/// when they are returned and never handed out again.
+///
+class BufferPool {
+public:
+    static constexpr size_t min_class_bits     = 8;
+    static constexpr size_t n_classes          = 40;
+    static constexpr size_t thread_cache_depth = 4;
+
+    ///
+    ///@brief Get the pool of this process
+    ///
+    ///@return BufferPool& the pool
+    ///
+    static BufferPool& instance() {
+        static BufferPool pool;
+        return pool;
+    }
+
+    BufferPool(const BufferPool& other) = delete;
+    BufferPool& operator=(const BufferPool& other) = delete;
+
+    ///
+    ///@brief Gets a buffer of at least the given size, thread-safe
+    ///
+    ///@param bytes requested size
+    ///@return void* cache line aligned buffer, to be returned with deallocate()
+    ///
+    void* allocate(size_t bytes) {
+        const size_t c = size_class(bytes);
+
+        auto* local = thread_cache();
+        if (local != nullptr && !local->blocks[c].empty()) {
+            void* p = local->blocks[c].back();
+            local->blocks[c].pop_back();
+            m_cached_bytes -= capacity(c);
+            return p;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_free[c].empty()) {
+                void* p = m_free[c].back();
+                m_free[c].pop_back();
+                m_cached_bytes -= capacity(c);
+                return p;
+            }
+        }
+        return fresh(c);
+    }
+
+    ///
+    ///@brief Returns a buffer to the pool, thread-safe
+    ///
+    ///@param p buffer of allocate(), may be nullptr
+    ///
+    void deallocate(void* p) noexcept {
+        if (p == nullptr) { return; }
+        if (header(p)->from_mpi != 0 && !mpi_usable()) { return; }
+        const size_t c = header(p)->size_class;
+
+        auto* local = thread_cache();
+        if (local != nullptr && local->blocks[c].size() < thread_cache_depth) {
+            local->blocks[c].push_back(p);
+            m_cached_bytes += capacity(c);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_cached_bytes + capacity(c) <= m_cache_limit) {
+                m_free[c].push_back(p);
+                m_cached_bytes += capacity(c);
+                return;
+            }
+        }
+        free_block(p);
+    }
+
+    ///
+    ///@brief Frees all the cached blocks, e.g. at MPI_Finalize. Must not run concurrently with
+    /// other uses of the pool.
+    ///
+    void release() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& list : m_free) { drain(list); }
+        for (auto* cache : m_caches) {
+            for (auto& list : cache->blocks) { drain(list); }
+        }
+    }
+
+    ///
+    ///@brief Sets the maximum number of bytes kept in the shared caches, default = 1 GiB
+    ///
+    ///@param bytes the limit
+    ///
+    void set_cache_limit(size_t bytes) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cache_limit = bytes;
+    }
+
+    ///
+    ///@brief Get the number of bytes in cached blocks
+    ///
+    ///@return size_t cached bytes
+    ///
+    size_t cached_bytes() const { return m_cached_bytes; }
+
+    ///
+    ///@brief Get the number of blocks obtained from MPI_Alloc_mem (or the heap) so far, constant in
+    /// the steady state of a program
+    ///
+    ///@return size_t number of fresh allocations
+    ///
+    size_t fresh_allocations() const { return m_fresh; }
+
+    ///
+    ///@brief Get the capacity of a size class
+    ///
+    ///@param c the size class
+    ///@return size_t usable bytes of the blocks of the class
+    ///
+    static constexpr size_t capacity(size_t c) { return size_t(1) << (c + min_class_bits); }
+
+    ///
+    ///@brief Get the size class of a request
+    ///
+    ///@param bytes requested size
+    ///@return size_t the smallest class holding bytes
+    ///
+    static size_t size_class(size_t bytes) {
+        size_t c = 0;
+        while (capacity(c) < bytes) { ++c; }
+        Utils::runtime_assert(c < n_classes, "Buffer too large for the pool.");
+        return c;
+    }
+
+private:
+    // stored just before the buffer
+    struct Header {
+        void*    raw;
+        uint32_t size_class;
+        uint32_t from_mpi;
+    };
+
+    static constexpr size_t slack = 2 * Utils::cache_line_size;
+
+    struct ThreadCache {
+        ThreadCache(BufferPool& p, bool& destroyed)
+            : pool(p)
+            , gone(destroyed) {
+            std::lock_guard<std::mutex> lock(pool.m_mutex);
+            pool.m_caches.push_back(this);
+        }
+
+        ThreadCache(const ThreadCache& other) = delete;
+        ThreadCache& operator=(const ThreadCache& other) = delete;
+
+        ~ThreadCache() {
+            gone = true;
+            std::lock_guard<std::mutex> lock(pool.m_mutex);
+            for (size_t c = 0; c < n_classes; ++c) {
+                pool.m_free[c].insert(pool.m_free[c].end(), blocks[c].begin(), blocks[c].end());
+            }
+            for (auto& cache : pool.m_caches) {
+                if (cache == this) {
+                    cache = pool.m_caches.back();
+                    pool.m_caches.pop_back();
+                    break;
+                }
+            }
+        }
+
+        BufferPool&                               pool;
+        bool&                                     gone;
+        std::array<std::vector<void*>, n_classes> blocks;
+    };
+
+    std::mutex                                m_mutex;
+    std::array<std::vector<void*>, n_classes> m_free;
+    std::vector<ThreadCache*>                 m_caches;
+    std::atomic<size_t>                       m_cached_bytes{0};
+    std::atomic<size_t>                       m_fresh{0};
+    size_t                                    m_cache_limit = size_t(1) << 30;
+    std::once_flag                            m_hook;
+    std::atomic<bool>                         m_mpi_closed{false};
+
+    BufferPool() = default;
+
+    ~BufferPool() { release(); }
+
+    ///
+    ///@brief Get the cache of the calling thread, nullptr while the thread exits
+    ///
+    ThreadCache* thread_cache() {
+        // trivially destructible, still valid after the cache has been destroyed
+        static thread_local bool destroyed = false;
+        if (destroyed) { return nullptr; }
+        static thread_local ThreadCache cache(*this, destroyed);
+        return &cache;
+    }
+
+    static Header* header(void* p) {
+        return reinterpret_cast<Header*>(static_cast<unsigned char*>(p) - sizeof(Header));
+    }
+
+    static bool mpi_active() { return Mpi::initialized() && !Mpi::finalized(); }
+
+    // false from the start of MPI_Finalize, when the attributes of MPI_COMM_SELF are deleted
+    bool mpi_usable() const { return !m_mpi_closed && mpi_active(); }
+
+    ///
+    ///@brief Allocates a new block of class c
+    ///
+    void* fresh(size_t c) {
+        const bool from_mpi = mpi_usable();
+        if (from_mpi) { std::call_once(m_hook, [this]() { hook_finalize(); }); }
+
+        const size_t bytes = capacity(c) + slack;
+        void* raw = from_mpi ? Mpi::alloc_mem(bytes, MPI_INFO_NULL) : ::operator new(bytes);
+
+        // the header fits between the raw pointer and the aligned buffer
+        auto addr = reinterpret_cast<uintptr_t>(raw) + sizeof(Header);
+        addr      = Utils::round_up(addr, Utils::cache_line_size);
+        void* p   = reinterpret_cast<void*>(addr);
+
+        Header* h     = header(p);
+        h->raw        = raw;
+        h->size_class = uint32_t(c);
+        h->from_mpi   = from_mpi ? 1 : 0;
+        ++m_fresh;
+        return p;
+    }
+
+    void free_block(void* p) const noexcept {
+        Header* h = header(p);
+        if (h->from_mpi == 0) {
+            ::operator delete(h->raw);
+        } else if (mpi_usable()) {
+            MPI_Free_mem(h->raw);
+        }
+        // memory of MPI_Alloc_mem can not be freed after MPI_Finalize
+    }
+
+    void drain(std::vector<void*>& list) {
+        for (void* p : list) {
+            m_cached_bytes -= capacity(header(p)->size_class);
+            free_block(p);
+        }
+        list.clear();
+    }
+
+    ///
+    ///@brief Releases the cached blocks when MPI_Finalize deletes the attributes of MPI_COMM_SELF,
+    /// blocks of MPI_Alloc_mem returned later are dropped
+    ///
+    void hook_finalize() {
+        auto on_delete = [](MPI_Comm, int, void* attr, void*) -> int {
+            auto* pool = static_cast<BufferPool*>(attr);
+            pool->release();
+            pool->m_mpi_closed = true;
+            return MPI_SUCCESS;
+        };
+        int keyval = Mpi::comm_create_keyval(MPI_COMM_NULL_COPY_FN, on_delete, nullptr);
+        Mpi::comm_set_attr(MPI_COMM_SELF, keyval, this);
+        // the attribute stays attached, only the key is not needed any more
+        Mpi::comm_free_keyval(keyval);
+    }
+};
+
+///
+///@brief Standard allocator drawing from the BufferPool, e.g. for the scratch and message
+/// buffers of the communication routines
+///
+///@tparam T value type
+///
+template <class T> struct PoolAllocator {
+
+    static_assert(alignof(T) <= Utils::cache_line_size, "Over-aligned type.");
+
+    using value_type = T;
+
+    PoolAllocator() = default;
+
+    template <class U> constexpr PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(BufferPool::instance().allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t) noexcept { BufferPool::instance().deallocate(p); }
+
+    template <class U> bool operator==(const PoolAllocator<U>&) const noexcept { return true; }
+
+    template <class U> bool operator!=(const PoolAllocator<U>&) const noexcept { return false; }
+};
+
+///
+///@brief Vector whose storage comes from the BufferPool
+///
+template <class T> using PoolVector = std::vector<T, PoolAllocator<T>>;
+
+} // namespace MpiWrapper
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <numeric> //std::accumulate
 #include <utility> //std pair
 
 #include "mpi_communicator.hpp"
@@ -28,21 +29,46 @@ public:
                      const std::array<size_t, N>& periods,
                      size_t                       reorder = 1,
                      const Communicator&          old     = Communicator())
-        : Communicator(Mpi::cart_create(old.get_handle(), topo_dims, periods, reorder)) {}
+        : Communicator(Mpi::cart_create(old.get_handle(), topo_dims, periods, reorder)) {
+        cache_topology();
+    }
 
+    ///
+    ///@brief Construct a new Cart Communicator object from a communicator which already has an N
+    /// dimensional Cartesian topology attached
+    ///
+    ///@param comm communicator with the topology, the ownership of the handle is shared
+    ///
+    explicit CartCommunicator(const Communicator& comm)
+        : Communicator(comm) {
+        cache_topology();
+    }
 
+    ///
+    ///@brief Creates the sub-grid communicator (MPI_Cart_sub) keeping the directions marked in the
+    /// mask. As an example, for N=3 the mask [1,0,0] gives the row of processes along x-direction
+    /// that this process belongs to. Collective over the communicator.
+    ///
+    ///@tparam M number of kept directions, has to equal the number of ones in the mask
+    ///@param mask 1 if the direction is kept, 0 if dropped
+    ///@return CartCommunicator<M> the sub-grid this process belongs to
+    ///
+    template <size_t M> CartCommunicator<M> sub(const std::array<size_t, N>& mask) const {
+
+        auto mask_int = Utils::cast_to_intarray(mask);
+        Utils::runtime_assert(
+            size_t(std::accumulate(mask_int.begin(), mask_int.end(), 0)) == M,
+            "Mask does not match the sub-grid dimension.");
+
+        return CartCommunicator<M>(Communicator(Mpi::cart_sub(this->get_handle(), mask_int.data())));
+    }
 
     ///
     ///@brief Get the coordrinates of this process in the cartesian mpi topology
     ///
     ///@return std::array<size_t, N> array of coordinates
     ///
-    std::array<size_t, N> get_coords() const {
-
-        std::array<int, N> coords;
-        Mpi::cart_coords(this->get_handle(), this->get_rank(), N, coords.begin());
-        return Utils::cast_to_uintarray(coords);
-    }
+    std::array<size_t, N> get_coords() const { return m_coords; }
 
     ///
     ///@brief Get the periodicity information
@@ -50,24 +76,14 @@ public:
     ///@return std::array<size_t, N> array of periodicity information corresponding to each
     /// direction N
     ///
-    std::array<size_t, N> get_periods() const {
-
-        std::array<int, N> dims, periods, coords;
-        Mpi::cart_get(this->get_handle(), N, dims.data(), periods.data(), coords.data());
-        return Utils::cast_to_uintarray(periods);
-    }
+    std::array<size_t, N> get_periods() const { return m_periods; }
 
     ///
     ///@brief Get the topology dimensions
     ///
     ///@return std::array<size_t, N> array of dimensions in each direction
     ///
-    std::array<size_t, N> get_topology_dims() const {
-
-        std::array<int, N> dims, periods, coords;
-        Mpi::cart_get(this->get_handle(), N, dims.data(), periods.data(), coords.data());
-        return Utils::cast_to_uintarray(dims);
-    }
+    std::array<size_t, N> get_topology_dims() const { return m_dims; }
 
     ///
     ///@brief Given an array of integers returns the corresponding source and destination ranks.
@@ -125,6 +141,23 @@ public:
 
 
 private:
+    // The topology never changes so it is queried once on construction.
+    std::array<size_t, N> m_dims{};
+    std::array<size_t, N> m_periods{};
+    std::array<size_t, N> m_coords{};
+
+    ///
+    ///@brief Queries the topology dimensions, periods and the coordinates of this process
+    ///
+    ///
+    void cache_topology() {
+        std::array<int, N> dims, periods, coords;
+        Mpi::cart_get(this->get_handle(), N, dims.data(), periods.data(), coords.data());
+        m_dims    = Utils::cast_to_uintarray(dims);
+        m_periods = Utils::cast_to_uintarray(periods);
+        m_coords  = Utils::cast_to_uintarray(coords);
+    }
+
     ///
     ///@brief Checks that the given input coordinates are in bounds in the mpi-topology. Fixes the
     /// coordinates
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <stdexcept>
+
+#include "mpi_communicator.hpp"
+#include "mpi_datatype_base.hpp"
+#include "mpi_functions.hpp"
+#include "mpi_request.hpp"
+#include "runtime_assert.hpp"
+
+namespace MpiWrapper {
+
+///
+///@brief A contiguous range of message tags [first, first + count)
+///
+struct TagRange {
+    int first = 0;
+    int count = 0;
+
+    bool contains(int tag) const { return tag >= first && tag < first + count; }
+};
+
+class Channel;
+
+///
+///@brief Hands out disjoint tag ranges on a communicator. The upper bound MPI_TAG_UB is queried
+/// once on construction. The ranges are assigned in the order of the reserve() calls, so all
+/// ranks have to reserve in the same order to agree on the tags. Tags below first_free are left
+/// for the plain Communicator calls which use tag 1 by default.
+///
+class TagAllocator {
+public:
+    static constexpr int default_first_tag = 16;
+
+    ///
+    ///@brief Construct a new Tag Allocator object
+    ///
+    ///@param comm communicator the tags are allocated on
+    ///@param first_free the first tag handed out, default = 16
+    ///
+    explicit TagAllocator(const Communicator& comm, int first_free = default_first_tag)
+        : m_comm(comm)
+        , m_next(first_free)
+        , m_tag_ub(Mpi::tag_ub(comm.get_handle())) {}
+
+    ///
+    ///@brief Reserves count consecutive tags, throws if the tag space is exhausted
+    ///
+    ///@param count number of tags to reserve
+    ///@return TagRange the reserved tags
+    ///
+    TagRange reserve(int count) {
+        Utils::runtime_assert(count > 0, "Empty tag range requested.");
+        if (count > m_tag_ub - m_next + 1) {
+            throw std::runtime_error("TagAllocator: tag space (MPI_TAG_UB) exhausted.");
+        }
+        TagRange range{m_next, count};
+        m_next += count;
+        return range;
+    }
+
+    ///
+    ///@brief Reserves count tags and wraps them in a Channel on the communicator
+    ///
+    ///@param count number of tags in the channel
+    ///@return Channel the new channel
+    ///
+    Channel channel(int count = 1);
+
+    ///
+    ///@brief Get the largest valid tag of the communicator
+    ///
+    ///@return int MPI_TAG_UB
+    ///
+    int tag_ub() const { return m_tag_ub; }
+
+    ///
+    ///@brief Get the number of tags still available
+    ///
+    ///@return int remaining tags
+    ///
+    int available() const { return m_tag_ub - m_next + 1; }
+
+private:
+    Communicator m_comm;
+    int          m_next;
+    int          m_tag_ub;
+};
+
+///
+///@brief A communicator together with a private range of tags. Exchanges on different channels
+/// can not match each other, so independent subsystems can communicate concurrently on the same
+/// communicator without barriers or duplicated handles. Tags are addressed with slot indices
+/// relative to the start of the range.
+///
+class Channel {
+public:
+    Channel(const Communicator& comm, TagRange tags)
+        : m_comm(comm)
+        , m_tags(tags) {}
+
+    ///
+    ///@brief Get the tag of the given slot
+    ///
+    ///@param slot index of the tag within the channel
+    ///@return int the message tag
+    ///
+    int tag(int slot = 0) const {
+        Utils::runtime_assert(slot >= 0 && slot < m_tags.count, "Channel slot out of range.");
+        return m_tags.first + slot;
+    }
+
+    ///
+    ///@brief Wrapper around MPI_Sendrecv using the tag of the given slot
+    ///
+    ///@param slot index of the tag within the channel, default = 0
+    ///
+    template <class T, class ST, class RT>
+    void send_recv(const T*                   send_buffer,
+                   int                        sendcount,
+                   const MpiDatatypeBase<ST>& sendtype,
+                   int                        dest_rank,
+                   T*                         recv_buffer,
+                   int                        recvcount,
+                   const MpiDatatypeBase<RT>& recvtype,
+                   int                        source_rank,
+                   int                        slot = 0) const {
+        m_comm.send_recv(send_buffer,
+                         sendcount,
+                         sendtype,
+                         dest_rank,
+                         recv_buffer,
+                         recvcount,
+                         recvtype,
+                         source_rank,
+                         tag(slot));
+    }
+
+    ///
+    ///@brief Wrapper around MPI_Isend using the tag of the given slot
+    ///
+    template <class T, class DT>
+    Request isend(const T*                   send_buffer,
+                  int                        sendcount,
+                  const MpiDatatypeBase<DT>& sendtype,
+                  int                        dest_rank,
+                  int                        slot = 0) const {
+        return m_comm.isend(send_buffer, sendcount, sendtype, dest_rank, tag(slot));
+    }
+
+    ///
+    ///@brief Wrapper around MPI_Irecv using the tag of the given slot
+    ///
+    template <class T, class DT>
+    Request irecv(T*                         recv_buffer,
+                  int                        recvcount,
+                  const MpiDatatypeBase<DT>& recvtype,
+                  int                        source_rank,
+                  int                        slot = 0) const {
+        return m_comm.irecv(recv_buffer, recvcount, recvtype, source_rank, tag(slot));
+    }
+
+    ///
+    ///@brief Get the underlying communicator
+    ///
+    ///@return const Communicator&
+    ///
+    const Communicator& get_communicator() const { return m_comm; }
+
+    ///
+    ///@brief Get the tags owned by the channel
+    ///
+    ///@return TagRange
+    ///
+    TagRange get_tags() const { return m_tags; }
+
+private:
+    Communicator m_comm;
+    TagRange     m_tags;
+};
+
+inline Channel TagAllocator::channel(int count) { return Channel(m_comm, reserve(count)); }
+
+} // namespace MpiWrapper
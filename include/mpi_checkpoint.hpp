@@ -0,0 +1,354 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mpi_array_io.hpp"
+#include "mpi_communicator.hpp"
+#include "mpi_distributed_array.hpp"
+#include "mpi_file.hpp"
+#include "mpi_functions.hpp"
+#include "mpi_native_datatypes.hpp"
+
+namespace MpiWrapper {
+
+///
+///@brief Fixed-size header of a checkpoint file. The header is followed, at data_offset, by the
+/// global array in C order. All fields are stored in the byte order of the writer, which is
+/// detected by byte_order.
+///
+struct CheckpointHeader {
+    static constexpr size_t   max_dims        = 8;
+    static constexpr uint32_t current_version = 1;
+    static constexpr uint32_t native_order    = 0x01020304;
+    static constexpr size_t   size_in_file    = 512; // data_offset, keeps the data page aligned
+
+    char     magic[8]     = {'M', 'P', 'I', 'W', 'C', 'K', 'P', 'T'};
+    uint32_t version      = current_version;
+    uint32_t byte_order   = native_order;
+    uint32_t n_dims       = 0;
+    uint32_t element_size = 0;
+    char     type_name[64]{};                // MPI_Type_get_name of the element type
+    uint64_t global_extents[max_dims]{};     // extents of the stored array
+    uint64_t topology_dims[max_dims]{};      // process grid of the writer, informational
+    uint64_t data_offset = size_in_file;     // offset of the data in bytes
+
+    ///
+    ///@brief Checks the magic, version and byte order, throws std::runtime_error on mismatch
+    ///
+    void validate() const {
+        CheckpointHeader reference;
+        if (std::memcmp(magic, reference.magic, sizeof(magic)) != 0) {
+            throw std::runtime_error("Not a checkpoint file.");
+        }
+        if (byte_order != native_order) {
+            throw std::runtime_error("Checkpoint has been written with another byte order.");
+        }
+        if (version != current_version) {
+            throw std::runtime_error("Unsupported checkpoint version.");
+        }
+        if (n_dims == 0 || n_dims > max_dims) {
+            throw std::runtime_error("Invalid checkpoint dimension.");
+        }
+    }
+
+    ///
+    ///@brief Checks that the file stores an N-dimensional array of T, throws std::runtime_error
+    /// on mismatch. The element type is compared by the name and size of MpiDatatype<T>, or only
+    /// by the size when MPI is not initialized, e.g. in serial tools.
+    ///
+    template <class T, size_t N> void validate_type() const {
+        validate();
+        if (n_dims != N) { throw std::runtime_error("Checkpoint dimension mismatch."); }
+        if (element_size != sizeof(T)) {
+            throw std::runtime_error("Checkpoint datatype mismatch.");
+        }
+        const bool mpi = Mpi::initialized() && !Mpi::finalized();
+        if (mpi && std::string(type_name) != Mpi::type_get_name(~MpiDatatype<T>())) {
+            throw std::runtime_error("Checkpoint datatype mismatch.");
+        }
+    }
+
+    ///
+    ///@brief Get the global extents of the stored array
+    ///
+    template <size_t N> std::array<size_t, N> extents() const {
+        std::array<size_t, N> ret{};
+        for (size_t i = 0; i < N; ++i) { ret[i] = size_t(global_extents[i]); }
+        return ret;
+    }
+
+    ///
+    ///@brief Checks that the data lies within a file of file_size bytes. The fields are not
+    /// trusted, corrupt extents or offsets do not overflow.
+    ///
+    bool data_fits(uint64_t file_size) const {
+        if (data_offset > file_size) { return false; }
+        const uint64_t available = file_size - data_offset;
+        for (size_t i = 0; i < n_dims; ++i) {
+            if (global_extents[i] == 0) { return true; }
+        }
+        uint64_t bytes = element_size;
+        for (size_t i = 0; i < n_dims; ++i) {
+            if (bytes > available / global_extents[i]) { return false; }
+            bytes *= global_extents[i];
+        }
+        return bytes <= available;
+    }
+
+    ///
+    ///@brief Get the number of stored elements
+    ///
+    size_t element_count() const {
+        size_t n = 1;
+        for (size_t i = 0; i < n_dims; ++i) { n *= size_t(global_extents[i]); }
+        return n;
+    }
+};
+
+static_assert(sizeof(CheckpointHeader) <= CheckpointHeader::size_in_file,
+              "Checkpoint header too large.");
+
+///
+///@brief Creates the header describing a distributed array
+///
+///@param arr the array
+///@return CheckpointHeader the header
+///
+template <class T, size_t N>
+CheckpointHeader make_checkpoint_header(const DistributedArray<T, N>& arr) {
+    static_assert(N <= CheckpointHeader::max_dims, "Too many dimensions for a checkpoint.");
+
+    CheckpointHeader h;
+    h.n_dims       = uint32_t(N);
+    h.element_size = uint32_t(sizeof(T));
+    auto name      = Mpi::type_get_name(~MpiDatatype<T>());
+    std::copy_n(name.begin(), std::min(name.size(), sizeof(h.type_name) - 1), h.type_name);
+
+    const auto global = arr.global_extents();
+    const auto topo   = arr.get_communicator().get_topology_dims();
+    for (size_t i = 0; i < N; ++i) {
+        h.global_extents[i] = uint64_t(global[i]);
+        h.topology_dims[i]  = uint64_t(topo[i]);
+    }
+    return h;
+}
+
+///
+///@brief Writes a self-describing checkpoint of a distributed array, collective over the
+/// communicator of arr. Rank 0 writes the header, the data is written collectively with
+/// write_array().
+///
+///@param path the file name
+///@param arr the array
+///@param hints tuning hints, default = none
+///
+template <class T, size_t N>
+void write_checkpoint(const std::string&            path,
+                      const DistributedArray<T, N>& arr,
+                      const FileHints&              hints = FileHints()) {
+    const auto header = make_checkpoint_header(arr);
+    auto       file   = File::create(arr.get_communicator(), path, hints);
+    if (arr.get_communicator().get_rank() == 0) {
+        std::array<unsigned char, CheckpointHeader::size_in_file> block{};
+        std::memcpy(block.data(), &header, sizeof(header));
+        file.write_at(0, block.data(), int(block.size()), MpiDatatype<unsigned char>());
+    }
+    write_array(file, arr, MPI_Offset(header.data_offset));
+}
+
+///
+///@brief Reads the header of a checkpoint, collective over the communicator. Rank 0 reads it and
+/// broadcasts it, throws std::runtime_error on all ranks if it is not a valid checkpoint.
+///
+///@param comm the communicator
+///@param file the opened checkpoint file
+///@return CheckpointHeader the header
+///
+inline CheckpointHeader read_checkpoint_header(const Communicator& comm, File& file) {
+    CheckpointHeader header;
+    if (comm.get_rank() == 0) {
+        if (file.size() >= MPI_Offset(sizeof(header))) {
+            file.read_at(0, &header, int(sizeof(header)), MpiDatatype<unsigned char>());
+        } else {
+            header.magic[0] = 0;
+        }
+    }
+    Mpi::bcast(&header, int(sizeof(header)), MPI_BYTE, 0, comm.get_handle());
+    header.validate();
+    return header;
+}
+
+///
+///@brief Restarts a distributed array from a checkpoint, collective over the communicator of arr.
+/// The process grid of arr does not have to match the one of the writer, every process reads
+/// only its own block. Throws std::runtime_error if the file does not store an array of the
+/// type, dimension and global extents of arr, or if it is truncated.
+///
+///@param path the file name
+///@param arr the array, the ghosts are exchanged after reading
+///@param hints tuning hints, default = none
+///@return CheckpointHeader the header of the file
+///
+template <class T, size_t N>
+CheckpointHeader read_checkpoint(const std::string&      path,
+                                 DistributedArray<T, N>& arr,
+                                 const FileHints&        hints = FileHints()) {
+    auto file   = File::open(arr.get_communicator(), path, hints);
+    auto header = read_checkpoint_header(arr.get_communicator(), file);
+    header.template validate_type<T, N>();
+    if (header.template extents<N>() != arr.global_extents()) {
+        throw std::runtime_error("Checkpoint extents mismatch.");
+    }
+    if (!header.data_fits(uint64_t(file.size()))) {
+        throw std::runtime_error("Truncated checkpoint file.");
+    }
+    read_array(file, arr, MPI_Offset(header.data_offset));
+    return header;
+}
+
+///
+///@brief Read-only memory mapping of a checkpoint for serial tools, e.g. post-processing or
+/// conversion. Blocks are copied directly from the page cache without MPI, which does not have
+/// to be initialized. The mapping is move-only and is released on destruction.
+///
+///@tparam T element type
+///@tparam N number of dimensions
+///
+template <class T, size_t N> class MappedCheckpoint {
+public:
+    ///
+    ///@brief Maps a checkpoint, throws std::runtime_error if the file can not be mapped or does
+    /// not store an N-dimensional array of T
+    ///
+    ///@param path the file name
+    ///
+    explicit MappedCheckpoint(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) { throw std::runtime_error("Can not open " + path + "."); }
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(CheckpointHeader)) {
+            ::close(fd);
+            throw std::runtime_error("Not a checkpoint file.");
+        }
+        m_bytes = size_t(st.st_size);
+        m_map   = ::mmap(nullptr, m_bytes, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (m_map == MAP_FAILED) {
+            m_map = nullptr;
+            throw std::runtime_error("Can not map " + path + ".");
+        }
+
+        std::memcpy(&m_header, m_map, sizeof(m_header));
+        try {
+            m_header.template validate_type<T, N>();
+            if (!m_header.data_fits(uint64_t(m_bytes))) {
+                throw std::runtime_error("Truncated checkpoint file.");
+            }
+        } catch (...) {
+            unmap();
+            throw;
+        }
+        m_extents = m_header.template extents<N>();
+    }
+
+    MappedCheckpoint(const MappedCheckpoint& other) = delete;
+    MappedCheckpoint& operator=(const MappedCheckpoint& other) = delete;
+
+    MappedCheckpoint(MappedCheckpoint&& other) noexcept
+        : m_map(other.m_map)
+        , m_bytes(other.m_bytes)
+        , m_header(other.m_header)
+        , m_extents(other.m_extents) {
+        other.m_map = nullptr;
+    }
+
+    MappedCheckpoint& operator=(MappedCheckpoint&& other) noexcept {
+        if (this != &other) {
+            unmap();
+            m_map       = other.m_map;
+            m_bytes     = other.m_bytes;
+            m_header    = other.m_header;
+            m_extents   = other.m_extents;
+            other.m_map = nullptr;
+        }
+        return *this;
+    }
+
+    ~MappedCheckpoint() { unmap(); }
+
+    ///
+    ///@brief Get the header of the file
+    ///
+    const CheckpointHeader& header() const { return m_header; }
+
+    ///
+    ///@brief Get the global extents of the stored array
+    ///
+    std::array<size_t, N> global_extents() const { return m_extents; }
+
+    ///
+    ///@brief Get the stored array in C order
+    ///
+    const T* data() const {
+        return reinterpret_cast<const T*>(static_cast<const char*>(m_map) + m_header.data_offset);
+    }
+
+    ///
+    ///@brief Element access by global index
+    ///
+    const T& operator()(const std::array<size_t, N>& idx) const {
+        size_t linear = 0;
+        for (size_t i = 0; i < N; ++i) { linear = linear * m_extents[i] + idx[i]; }
+        return data()[linear];
+    }
+
+    ///
+    ///@brief Copies the block [starts, starts + sizes) to a contiguous C-order buffer
+    ///
+    ///@param starts first global index of the block
+    ///@param sizes extents of the block
+    ///@param out the destination buffer
+    ///
+    void read_block(const std::array<size_t, N>& starts,
+                    const std::array<size_t, N>& sizes,
+                    T*                           out) const {
+        for (size_t i = 0; i < N; ++i) {
+            Utils::runtime_assert(starts[i] + sizes[i] <= m_extents[i], "Block out of bounds.");
+            if (sizes[i] == 0) { return; }
+        }
+        size_t rows = 1;
+        for (size_t i = 0; i + 1 < N; ++i) { rows *= sizes[i]; }
+        for (size_t r = 0; r < rows; ++r) {
+            std::array<size_t, N> idx = starts;
+            size_t                rest = r;
+            for (size_t d = N - 1; d-- > 0;) {
+                idx[d] += rest % sizes[d];
+                rest /= sizes[d];
+            }
+            std::copy_n(&(*this)(idx), sizes[N - 1], out + r * sizes[N - 1]);
+        }
+    }
+
+private:
+    void*                 m_map   = nullptr;
+    size_t                m_bytes = 0;
+    CheckpointHeader      m_header;
+    std::array<size_t, N> m_extents{};
+
+    void unmap() {
+        if (m_map != nullptr) { ::munmap(m_map, m_bytes); }
+        m_map = nullptr;
+    }
+};
+
+} // namespace MpiWrapper
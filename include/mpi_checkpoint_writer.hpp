@@ -0,0 +1,219 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#endif
+
+#include "mpi_array_io.hpp"
+#include "mpi_distributed_array.hpp"
+#include "mpi_file.hpp"
+#include "mpi_native_datatypes.hpp"
+#include "mpi_request_scheduler.hpp"
+#include "runtime_assert.hpp"
+
+namespace MpiWrapper {
+
+///
+///@brief Writes checkpoints of distributed arrays in the background. write() copies the interior
+/// of the array into a staging buffer and starts a nonblocking MPI_File_iwrite_all, the solver
+/// may modify the array right away. The requests are tracked by a RequestScheduler: the staging
+/// buffer of a checkpoint is released as soon as its write completes locally.
+///
+/// At most max_in_flight checkpoints are pending, write() retires the oldest one when the limit
+/// is reached, so the staging memory is bounded. Closing a file is collective, therefore the
+/// files are closed in write order by write(), wait() and wait_all(), which every process has
+/// to call in the same order. Under C++20 a checkpoint can be co_await:ed, the coroutine is
+/// resumed from the progress() of the scheduler.
+///
+class CheckpointWriter {
+public:
+    ///
+    ///@brief Construct a new Checkpoint Writer
+    ///
+    ///@param max_in_flight maximum number of pending checkpoints, default = 2
+    ///@param hints tuning hints of the checkpoint files, default = none
+    ///@param scheduler scheduler tracking the writes, default = the one of this thread
+    ///
+    explicit CheckpointWriter(size_t            max_in_flight = 2,
+                              const FileHints&  hints         = FileHints(),
+                              RequestScheduler& scheduler     = RequestScheduler::this_thread())
+        : m_max_in_flight(max_in_flight)
+        , m_hints(hints)
+        , m_scheduler(scheduler) {
+        Utils::runtime_assert(max_in_flight > 0, "Invalid number of checkpoints in flight.");
+    }
+
+    CheckpointWriter(const CheckpointWriter& other) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter& other) = delete;
+
+    ///
+    ///@brief Waits for all the pending checkpoints, collective
+    ///
+    ~CheckpointWriter() { wait_all(); }
+
+    ///
+    ///@brief Starts a checkpoint of the interior of arr, collective over the communicator of arr.
+    /// The file holds the global C-order array at offset disp, same as write_array().
+    ///
+    ///@param arr the array, may be modified after the call
+    ///@param path the file name
+    ///@param disp offset of the array in bytes, default = 0
+    ///@return size_t id of the checkpoint
+    ///
+    template <class T, size_t N>
+    size_t write(const DistributedArray<T, N>& arr, const std::string& path, MPI_Offset disp = 0) {
+
+        while (m_checkpoints.size() >= m_max_in_flight) { retire(); }
+
+        m_checkpoints.emplace_back(File::create(arr.get_communicator(), path, m_hints));
+        Checkpoint& c = m_checkpoints.back();
+
+        c.staging.resize(arr.local_size() * sizeof(T));
+        arr.copy_interior(reinterpret_cast<T*>(c.staging.data()));
+
+        auto filetype = array_filetype(arr);
+        c.file.set_view(disp, MpiDatatype<T>(), filetype);
+        auto request = c.file.iwrite_all(
+            reinterpret_cast<const T*>(c.staging.data()), int(arr.local_size()), MpiDatatype<T>());
+
+        m_scheduler.submit(std::move(request), [&c]() {
+            c.done = true;
+            c.staging.clear();
+            c.staging.shrink_to_fit();
+            // a resumed waiter may retire c, it must not be touched afterwards
+            auto waiters = std::move(c.waiters);
+            c.waiters.clear();
+            for (auto& waiter : waiters) { waiter(); }
+        });
+
+        return m_next_id++;
+    }
+
+    ///
+    ///@brief Tests for the local completion of a checkpoint without blocking. Throws
+    /// std::out_of_range for an id not returned by write().
+    ///
+    ///@param id the checkpoint id
+    ///@return true if the data of this process has been written
+    ///
+    bool test(size_t id) {
+        check_id(id);
+        m_scheduler.progress();
+        return is_done(id);
+    }
+
+    ///
+    ///@brief Waits for a checkpoint and closes the files up to and including it, collective.
+    /// Throws std::out_of_range for an id not returned by write().
+    ///
+    ///@param id the checkpoint id
+    ///
+    void wait(size_t id) {
+        check_id(id);
+        while (m_first_id <= id && !m_checkpoints.empty()) { retire(); }
+    }
+
+    ///
+    ///@brief Waits for all the checkpoints and closes their files, collective
+    ///
+    void wait_all() {
+        while (!m_checkpoints.empty()) { retire(); }
+    }
+
+    ///
+    ///@brief Get the number of checkpoints whose files are still open
+    ///
+    ///@return size_t number of pending checkpoints
+    ///
+    size_t in_flight() const { return m_checkpoints.size(); }
+
+#if defined(__cpp_impl_coroutine)
+
+    ///
+    ///@brief Awaitable which suspends the awaiting coroutine until a checkpoint has completed
+    /// locally
+    ///
+    class Awaitable {
+    public:
+        Awaitable(CheckpointWriter& writer, size_t id)
+            : m_writer(writer)
+            , m_id(id) {}
+
+        bool await_ready() { return m_writer.test(m_id); }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            m_writer.find(m_id).waiters.push_back([handle]() { handle.resume(); });
+        }
+
+        void await_resume() const noexcept {}
+
+    private:
+        CheckpointWriter& m_writer;
+        size_t            m_id;
+    };
+
+    ///
+    ///@brief Makes the checkpoint awaitable, the file stays open until wait() or wait_all()
+    ///
+    ///@param id the checkpoint id
+    ///@return Awaitable object to co_await on
+    ///
+    Awaitable async(size_t id) { return Awaitable(*this, id); }
+
+#endif
+
+private:
+    struct Checkpoint {
+        explicit Checkpoint(File&& f)
+            : file(std::move(f)) {}
+
+        File                               file;
+        std::vector<unsigned char>         staging; // exact size, freed on completion
+        bool                               done = false;
+        std::vector<std::function<void()>> waiters;
+    };
+
+    size_t            m_max_in_flight;
+    FileHints         m_hints;
+    RequestScheduler& m_scheduler;
+
+    // references to the elements stay valid on push_back and pop_front
+    std::deque<Checkpoint> m_checkpoints;
+    size_t                 m_first_id = 0;
+    size_t                 m_next_id  = 0;
+
+    void check_id(size_t id) const {
+        if (id >= m_next_id) { throw std::out_of_range("Unknown checkpoint id."); }
+    }
+
+    bool is_done(size_t id) const {
+        check_id(id);
+        if (id < m_first_id) { return true; }
+        return m_checkpoints[id - m_first_id].done;
+    }
+
+    Checkpoint& find(size_t id) {
+        check_id(id);
+        if (id < m_first_id) { throw std::out_of_range("Checkpoint already retired."); }
+        return m_checkpoints[id - m_first_id];
+    }
+
+    ///
+    ///@brief Completes the oldest checkpoint and closes its file
+    ///
+    void retire() {
+        Checkpoint& c = m_checkpoints.front();
+        while (!c.done) { m_scheduler.progress(); }
+        c.file.close();
+        m_checkpoints.pop_front();
+        ++m_first_id;
+    }
+};
+
+} // namespace MpiWrapper
@@ -1,35 +1,124 @@
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include "mpi_datatype_base.hpp"
 #include "mpi_functions.hpp"
+#include "mpi_request.hpp"
 
 namespace MpiWrapper {
 
+///
+///@brief Reference-counted wrapper around an MPI_Comm handle. Copies share the ownership of the
+/// handle and the handle is freed when the last owner goes away, moves only transfer the
+/// ownership. A new handle is only created by an explicit dup().
+///
 class Communicator {
 public:
     // default to world
     Communicator()
-        : m_handle(MPI_COMM_WORLD)
-        , m_should_free(false) {}
+        : m_handle(MPI_COMM_WORLD) {}
 
+    // takes the ownership of the handle
     explicit Communicator(MPI_Comm handle)
         : m_handle(handle)
-        , m_should_free(true) {}
+        , m_owner(make_owner(handle)) {}
 
-    // copy
-    Communicator(const Communicator& other)
-        : m_handle(other.m_handle)
-        , m_should_free(false) {}
+    // copy, shares the ownership
+    Communicator(const Communicator& other) = default;
 
-    // move
-    Communicator(Communicator&& other)
+    // move, leaves other as MPI_COMM_NULL
+    Communicator(Communicator&& other) noexcept
         : m_handle(other.m_handle)
-        , m_should_free(other.m_should_free) {
-        other.m_should_free = false;
+        , m_owner(std::move(other.m_owner)) {
+        other.m_handle = MPI_COMM_NULL;
+    }
+
+    Communicator& operator=(const Communicator& other) = default;
+
+    Communicator& operator=(Communicator&& other) noexcept {
+        if (this != &other) {
+            m_handle       = other.m_handle;
+            m_owner        = std::move(other.m_owner);
+            other.m_handle = MPI_COMM_NULL;
+        }
+        return *this;
     }
 
     ~Communicator() { free(); }
 
+    ///
+    ///@brief Creates a non-owning view of a handle managed elsewhere
+    ///
+    ///@param handle the handle to wrap
+    ///@return Communicator which never frees the handle
+    ///
+    static Communicator borrow(MPI_Comm handle) {
+        Communicator ret;
+        ret.m_handle = handle;
+        return ret;
+    }
+
+    ///
+    ///@brief Duplicates the communicator with MPI_Comm_dup, collective over the communicator
+    ///
+    ///@return Communicator an independent communicator owning the new handle
+    ///
+    Communicator dup() const { return Communicator(Mpi::comm_dup(m_handle)); }
+
+    ///
+    ///@brief Partitions the communicator with MPI_Comm_split, collective over the communicator
+    ///
+    ///@param color processes with the same color end up in the same communicator, MPI_UNDEFINED
+    /// gives a null communicator
+    ///@param key determines the rank order in the new communicator, default = 0 (keep the order)
+    ///@return Communicator owning the new handle
+    ///
+    Communicator split(int color, int key = 0) const {
+        return Communicator(Mpi::comm_split(m_handle, color, key));
+    }
+
+    ///
+    ///@brief Partitions the communicator with MPI_Comm_split_type, collective over the communicator
+    ///
+    ///@param type the split type, default = MPI_COMM_TYPE_SHARED (processes sharing memory)
+    ///@param key determines the rank order in the new communicator, default = 0 (keep the order)
+    ///@return Communicator owning the new handle
+    ///
+    Communicator split_type(int type = MPI_COMM_TYPE_SHARED, int key = 0) const {
+        return Communicator(Mpi::comm_split_type(m_handle, type, key));
+    }
+
+    ///
+    ///@brief Creates a communicator of the given ranks with MPI_Comm_create, collective over the
+    /// communicator
+    ///
+    ///@param ranks ranks of this communicator to include, all processes pass the same ranks
+    ///@return Communicator owning the new handle, null on processes not in ranks
+    ///
+    Communicator create(const std::vector<int>& ranks) const {
+        MPI_Group group = make_group(ranks);
+        MPI_Comm  ret   = Mpi::comm_create(m_handle, group);
+        Mpi::group_free(group);
+        return Communicator(ret);
+    }
+
+    ///
+    ///@brief Creates a communicator of the given ranks with MPI_Comm_create_group, only the
+    /// processes in ranks take part in the call
+    ///
+    ///@param ranks ranks of this communicator to include, the calling process must be one of them
+    ///@param tag tag to distinguish concurrent creations on the same communicator, default = 0
+    ///@return Communicator owning the new handle
+    ///
+    Communicator create_group(const std::vector<int>& ranks, int tag = 0) const {
+        MPI_Group group = make_group(ranks);
+        MPI_Comm  ret   = Mpi::comm_create_group(m_handle, group, tag);
+        Mpi::group_free(group);
+        return Communicator(ret);
+    }
+
     ///
     ///@brief Wrapper around MPI_Sendrecv
     ///
@@ -44,6 +133,7 @@ public:
     ///@param recvcount   number of recvtype to receive
     ///@param recvtype    mpi-datatype of the reveived element
     ///@param source_rank rank of the source
+    ///@param tag         tag of both the sent and the received message, default = 1
     ///
     template <class T, class ST, class RT>
     void send_recv(const T*                   send_buffer,
@@ -53,11 +143,12 @@ public:
                    T*                         recv_buffer,
                    int                        recvcount,
                    const MpiDatatypeBase<RT>& recvtype,
-                   int                        source_rank) {
+                   int                        source_rank,
+                   int                        tag = 1) const {
 
         // MPI_Status status;
-        int sendtag = 1;
-        int recvtag = 1;
+        int sendtag = tag;
+        int recvtag = tag;
         int err     = MPI_Sendrecv(send_buffer,
                                sendcount,
                                ~sendtype,
@@ -74,6 +165,48 @@ public:
         if (err != MPI_SUCCESS) { throw "MPI_Sendrcv() fails."; }
     }
 
+    ///
+    ///@brief Wrapper around MPI_Isend
+    ///
+    ///@tparam T send buffer type
+    ///@tparam DT sendtype base class
+    ///@param send_buffer buffer to take the send data from, must stay alive until completion
+    ///@param sendcount   number of sendtypes to send
+    ///@param sendtype    the mpi-datatype of the send element
+    ///@param dest_rank   rank of the destination
+    ///@param tag         message tag, default = 1
+    ///@return Request    the pending send
+    ///
+    template <class T, class DT>
+    Request isend(const T*                   send_buffer,
+                  int                        sendcount,
+                  const MpiDatatypeBase<DT>& sendtype,
+                  int                        dest_rank,
+                  int                        tag = 1) const {
+        return Request(Mpi::isend(send_buffer, sendcount, ~sendtype, dest_rank, tag, m_handle));
+    }
+
+    ///
+    ///@brief Wrapper around MPI_Irecv
+    ///
+    ///@tparam T receive buffer type
+    ///@tparam DT recvtype base class
+    ///@param recv_buffer buffer to place the received data, must stay alive until completion
+    ///@param recvcount   maximum number of recvtypes to receive
+    ///@param recvtype    mpi-datatype of the received element
+    ///@param source_rank rank of the source
+    ///@param tag         message tag, default = 1
+    ///@return Request    the pending receive
+    ///
+    template <class T, class DT>
+    Request irecv(T*                         recv_buffer,
+                  int                        recvcount,
+                  const MpiDatatypeBase<DT>& recvtype,
+                  int                        source_rank,
+                  int                        tag = 1) const {
+        return Request(Mpi::irecv(recv_buffer, recvcount, ~recvtype, source_rank, tag, m_handle));
+    }
+
     ///
     ///@brief Get the mpi-handle
     ///
@@ -97,9 +230,17 @@ public:
     ///
     int size() const { return Mpi::comm_size(m_handle); }
 
+    ///
+    ///@brief Checks if the communicator is MPI_COMM_NULL (e.g. moved-from or not a member of a
+    /// created sub-communicator)
+    ///
+    ///@return true if the handle is MPI_COMM_NULL
+    ///
+    bool is_null() const { return m_handle == MPI_COMM_NULL; }
+
 private:
-    MPI_Comm m_handle;
-    bool     m_should_free;
+    MPI_Comm                  m_handle;
+    std::shared_ptr<MPI_Comm> m_owner; // null if the handle is not owned
 
     ///
     ///@brief Check if the handle is a builtin type which sould not be freed
@@ -108,17 +249,43 @@ private:
     ///@return true is a builtin type
     ///@return false not a builtin type
     ///
-    bool is_builtin(MPI_Comm c) const {
+    static bool is_builtin(MPI_Comm c) {
         return c == MPI_COMM_WORLD || c == MPI_COMM_SELF || c == MPI_COMM_NULL;
     }
 
     ///
-    ///@brief Safely free m_handle
+    ///@brief Creates the group of the given ranks of this communicator
     ///
+    ///@param ranks ranks to include
+    ///@return MPI_Group the group, has to be freed with Mpi::group_free
     ///
-    void free() {
-        if (!is_builtin(m_handle) && m_should_free) { Mpi::comm_free(m_handle); }
+    MPI_Group make_group(const std::vector<int>& ranks) const {
+        MPI_Group parent = Mpi::comm_group(m_handle);
+        MPI_Group ret    = Mpi::group_incl(parent, static_cast<int>(ranks.size()), ranks.data());
+        Mpi::group_free(parent);
+        return ret;
     }
+
+    ///
+    ///@brief Creates the shared owner of the handle, the handle is freed when the last owner is
+    /// released unless mpi has already been finalized.
+    ///
+    ///@param handle the handle to own
+    ///@return std::shared_ptr<MPI_Comm> owner, null for builtin handles
+    ///
+    static std::shared_ptr<MPI_Comm> make_owner(MPI_Comm handle) {
+        if (is_builtin(handle)) { return nullptr; }
+        return std::shared_ptr<MPI_Comm>(new MPI_Comm(handle), [](MPI_Comm* h) {
+            if (!Mpi::finalized()) { Mpi::comm_free(*h); }
+            delete h;
+        });
+    }
+
+    ///
+    ///@brief Safely release this owner of m_handle, frees the handle if this was the last one
+    ///
+    ///
+    void free() { m_owner.reset(); }
 };
 
-} // namespace MpiWrapper
\ No newline at end of file
+} // namespace MpiWrapper
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <vector>
+
+#include "mpi_communicator.hpp"
+#include "mpi_functions.hpp"
+#include "runtime_assert.hpp"
+
+namespace MpiWrapper {
+
+///
+///@brief Assertions about the communication pattern which allow the mpi library to skip work
+/// in the message matching. The keys are defined by MPI-4, older libraries ignore them.
+///
+struct CommunicatorHints {
+    bool no_any_tag       = false; // mpi_assert_no_any_tag
+    bool no_any_source    = false; // mpi_assert_no_any_source
+    bool exact_length     = false; // mpi_assert_exact_length
+    bool allow_overtaking = false; // mpi_assert_allow_overtaking
+
+    bool any() const { return no_any_tag || no_any_source || exact_length || allow_overtaking; }
+};
+
+///
+///@brief A set of duplicates of a parent communicator meant to be used one per thread under
+/// MPI_THREAD_MULTIPLE. Each duplicate has its own matching queue so threads communicating on
+/// different handles do not serialize inside the mpi library. Construction is collective over the
+/// parent and thread i on every rank should use the handle at index i.
+///
+class CommunicatorPool {
+public:
+    ///
+    ///@brief Construct a new Communicator Pool object
+    ///
+    ///@param parent the communicator to duplicate
+    ///@param count number of duplicates (typically the number of threads)
+    ///@param hints optional assertions attached to each duplicate
+    ///
+    CommunicatorPool(const Communicator&      parent,
+                     size_t                   count,
+                     const CommunicatorHints& hints = CommunicatorHints()) {
+
+        Utils::runtime_assert(count > 0, "Empty communicator pool.");
+
+        m_comms.reserve(count);
+
+        if (hints.any()) {
+            MPI_Info info = make_info(hints);
+            for (size_t i = 0; i < count; ++i) {
+                m_comms.emplace_back(Mpi::comm_dup_with_info(parent.get_handle(), info));
+            }
+            Mpi::info_free(info);
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                m_comms.emplace_back(Mpi::comm_dup(parent.get_handle()));
+            }
+        }
+    }
+
+    CommunicatorPool(const CommunicatorPool& other) = delete;
+    CommunicatorPool& operator=(const CommunicatorPool& other) = delete;
+
+    ///
+    ///@brief Get the communicator of the given thread
+    ///
+    ///@param thread_idx index of the thread
+    ///@return const Communicator& the handle dedicated to the thread
+    ///
+    const Communicator& operator[](size_t thread_idx) const {
+        Utils::runtime_assert(thread_idx < m_comms.size(), "Communicator pool index out of bounds.");
+        return m_comms[thread_idx];
+    }
+
+    ///
+    ///@brief Get the number of communicators in the pool
+    ///
+    ///@return size_t pool size
+    ///
+    size_t size() const { return m_comms.size(); }
+
+private:
+    std::vector<Communicator> m_comms;
+
+    static MPI_Info make_info(const CommunicatorHints& hints) {
+        MPI_Info info = Mpi::info_create();
+        if (hints.no_any_tag) { Mpi::info_set(info, "mpi_assert_no_any_tag", "true"); }
+        if (hints.no_any_source) { Mpi::info_set(info, "mpi_assert_no_any_source", "true"); }
+        if (hints.exact_length) { Mpi::info_set(info, "mpi_assert_exact_length", "true"); }
+        if (hints.allow_overtaking) { Mpi::info_set(info, "mpi_assert_allow_overtaking", "true"); }
+        return info;
+    }
+};
+
+} // namespace MpiWrapper
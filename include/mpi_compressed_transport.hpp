@@ -0,0 +1,275 @@
+#pragma once
+
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include <mpi.h>
+
+#include "compression.hpp"
+#include "mpi_buffer_pool.hpp"
+#include "mpi_communicator.hpp"
+#include "mpi_functions.hpp"
+#include "runtime_assert.hpp"
+
+namespace MpiWrapper {
+
+///
+///@brief Settings of a CompressedTransport
+///
+struct CompressionOptions {
+    size_t threshold   = 16384; // messages below this many bytes are never compressed
+    double min_ratio   = 1.25;  // compression has to shrink a message at least by this factor
+    size_t backoff     = 16;    // messages sent raw after a compression attempt did not pay off
+    double error_bound = 0.0;   // > 0 enables the lossy mode with this absolute error bound
+};
+
+///
+///@brief Point-to-point transport which compresses large messages of arithmetic types before
+/// sending, trading CPU time for bandwidth on slow links. Payloads are byte-shuffled and LZ
+/// coded (Utils::lz_compress), in the lossy mode floating-point values are first quantized to
+/// the error bound (Utils::quantize), e.g. for visualization output.
+///
+/// Only messages of at least options.threshold bytes are compressed, and only if the achieved
+/// ratio reaches options.min_ratio; otherwise the raw data is sent and compression is suspended
+/// for the next options.backoff messages. A compressed message is always smaller than the raw
+/// one, so the receiver tells them apart by the probed size and raw messages are received in
+/// place. Sender and receiver do not have to agree on the options.
+///
+///@tparam T arithmetic element type
+///
+template <class T> class CompressedTransport {
+
+    static_assert(std::is_arithmetic_v<T>, "Compression of arithmetic types only.");
+
+public:
+    ///
+    ///@brief Construct a new Compressed Transport
+    ///
+    ///@param comm the communicator
+    ///@param options compression settings, default = lossless above 16 KiB
+    ///
+    explicit CompressedTransport(const Communicator&       comm,
+                                 const CompressionOptions& options = CompressionOptions())
+        : m_comm(comm)
+        , m_options(options) {
+        Utils::runtime_assert(options.min_ratio >= 1.0, "Invalid minimum compression ratio.");
+        Utils::runtime_assert(options.error_bound == 0.0 || std::is_floating_point_v<T>,
+                              "Lossy compression of floating-point types only.");
+    }
+
+    ///
+    ///@brief Blocking send of n elements
+    ///
+    ///@param data the elements
+    ///@param n number of elements
+    ///@param dest rank of the destination
+    ///@param tag message tag, default = 1
+    ///
+    void send(const T* data, size_t n, int dest, int tag = 1) {
+        if (encode(data, n)) {
+            Mpi::send(
+                m_send.data(), int(m_send.size()), MPI_BYTE, dest, tag, m_comm.get_handle());
+        } else {
+            Mpi::send(data, raw_count(n), MPI_BYTE, dest, tag, m_comm.get_handle());
+        }
+    }
+
+    ///
+    ///@brief Blocking receive of n elements, the size has to match the sent message
+    ///
+    ///@param data buffer for the elements
+    ///@param n number of elements
+    ///@param source rank of the source, may be MPI_ANY_SOURCE
+    ///@param tag message tag, default = 1
+    ///
+    void recv(T* data, size_t n, int source, int tag = 1) {
+        MPI_Status status = Mpi::probe(source, tag, m_comm.get_handle());
+        receive(status, data, n);
+    }
+
+    ///
+    ///@brief Sends to dest and receives from source, e.g. one direction of a halo exchange.
+    /// The send does not block the receive, so all processes may call this at the same time.
+    ///
+    ///@param send_data the elements to send
+    ///@param n_send number of elements to send
+    ///@param dest rank of the destination
+    ///@param recv_data buffer for the received elements
+    ///@param n_recv number of elements to receive
+    ///@param source rank of the source
+    ///@param tag message tag, default = 1
+    ///
+    void send_recv(const T* send_data,
+                   size_t   n_send,
+                   int      dest,
+                   T*       recv_data,
+                   size_t   n_recv,
+                   int      source,
+                   int      tag = 1) {
+        MPI_Request request;
+        if (encode(send_data, n_send)) {
+            request = Mpi::isend(
+                m_send.data(), int(m_send.size()), MPI_BYTE, dest, tag, m_comm.get_handle());
+        } else {
+            request = Mpi::isend(
+                send_data, raw_count(n_send), MPI_BYTE, dest, tag, m_comm.get_handle());
+        }
+        recv(recv_data, n_recv, source, tag);
+        Mpi::wait(request);
+    }
+
+    ///
+    ///@brief Get the number of bytes handed to send(), before compression
+    ///
+    size_t raw_bytes() const { return m_raw_bytes; }
+
+    ///
+    ///@brief Get the number of bytes sent over the network
+    ///
+    size_t sent_bytes() const { return m_sent_bytes; }
+
+    ///
+    ///@brief Get the overall compression ratio raw_bytes() / sent_bytes()
+    ///
+    double ratio() const {
+        return m_sent_bytes == 0 ? 1.0 : double(m_raw_bytes) / double(m_sent_bytes);
+    }
+
+    ///
+    ///@brief Get the number of messages which have been sent compressed
+    ///
+    size_t compressed_messages() const { return m_compressed; }
+
+private:
+    enum : uint32_t { lossless = 1, lossy = 2 };
+
+    struct Header {
+        uint32_t mode;
+        uint32_t element_size;
+        uint64_t n;
+        double   error_bound;
+    };
+
+    Communicator               m_comm;
+    CompressionOptions         m_options;
+    PoolVector<unsigned char> m_send;
+    PoolVector<unsigned char> m_recv;
+    PoolVector<unsigned char> m_scratch;
+    PoolVector<uint64_t>      m_quantized;
+    PoolVector<size_t>        m_table;
+    size_t                    m_skip       = 0;
+    size_t                    m_raw_bytes  = 0;
+    size_t                    m_sent_bytes = 0;
+    size_t                    m_compressed = 0;
+
+    static int raw_count(size_t n) {
+        Utils::runtime_assert(n * sizeof(T) <= size_t(INT_MAX), "Message too large.");
+        return int(n * sizeof(T));
+    }
+
+    ///
+    ///@brief Compresses the data into m_send if that pays off
+    ///
+    ///@return true if m_send holds the message to send
+    ///@return false if the raw data has to be sent
+    ///
+    bool encode(const T* data, size_t n) {
+        const size_t raw = size_t(raw_count(n));
+        m_raw_bytes += raw;
+
+        if (raw < m_options.threshold || raw == 0) {
+            m_sent_bytes += raw;
+            return false;
+        }
+        if (m_skip > 0) {
+            --m_skip;
+            m_sent_bytes += raw;
+            return false;
+        }
+
+        Header header{lossless, uint32_t(sizeof(T)), uint64_t(n), m_options.error_bound};
+        m_send.resize(sizeof(Header));
+        m_scratch.resize(raw);
+
+        bool quantized = false;
+        if constexpr (std::is_floating_point_v<T>) {
+            if (m_options.error_bound > 0.0) {
+                m_quantized.resize(n);
+                quantized = Utils::quantize(data, n, m_options.error_bound, m_quantized.data());
+            }
+        }
+        if (quantized) {
+            header.mode = lossy;
+            m_scratch.resize(n * sizeof(uint64_t));
+            Utils::byte_shuffle(reinterpret_cast<const unsigned char*>(m_quantized.data()),
+                                n,
+                                sizeof(uint64_t),
+                                m_scratch.data());
+        } else {
+            Utils::byte_shuffle(
+                reinterpret_cast<const unsigned char*>(data), n, sizeof(T), m_scratch.data());
+        }
+        Utils::lz_compress(m_scratch.data(), m_scratch.size(), m_send, m_table);
+        std::memcpy(m_send.data(), &header, sizeof(Header));
+
+        // strictly smaller, the receiver relies on it
+        if (m_send.size() >= raw || double(raw) < m_options.min_ratio * double(m_send.size())) {
+            m_skip = m_options.backoff;
+            m_sent_bytes += raw;
+            return false;
+        }
+        m_sent_bytes += m_send.size();
+        ++m_compressed;
+        return true;
+    }
+
+    ///
+    ///@brief Receives a probed message and decompresses it if necessary
+    ///
+    void receive(const MPI_Status& status, T* data, size_t n) {
+        const int    bytes = Mpi::get_count(status, MPI_BYTE);
+        const size_t raw   = size_t(raw_count(n));
+        const int    tag   = status.MPI_TAG;
+        const int    from  = status.MPI_SOURCE;
+
+        if (size_t(bytes) == raw) {
+            Mpi::recv(data, bytes, MPI_BYTE, from, tag, m_comm.get_handle());
+            return;
+        }
+        Utils::runtime_assert(size_t(bytes) > sizeof(Header) && size_t(bytes) < raw,
+                              "Unexpected message size.");
+
+        m_recv.resize(size_t(bytes));
+        Mpi::recv(m_recv.data(), bytes, MPI_BYTE, from, tag, m_comm.get_handle());
+
+        Header header;
+        std::memcpy(&header, m_recv.data(), sizeof(Header));
+        Utils::runtime_assert(header.n == n && header.element_size == sizeof(T),
+                              "Compressed message does not match the receive buffer.");
+
+        const unsigned char* payload = m_recv.data() + sizeof(Header);
+        const size_t         n_in    = m_recv.size() - sizeof(Header);
+        if (header.mode == lossy) {
+            if constexpr (std::is_floating_point_v<T>) {
+                m_scratch.resize(n * sizeof(uint64_t));
+                m_quantized.resize(n);
+                Utils::lz_decompress(payload, n_in, m_scratch.data(), m_scratch.size());
+                Utils::byte_unshuffle(m_scratch.data(),
+                                      n,
+                                      sizeof(uint64_t),
+                                      reinterpret_cast<unsigned char*>(m_quantized.data()));
+                Utils::dequantize(m_quantized.data(), n, header.error_bound, data);
+            }
+        } else {
+            m_scratch.resize(raw);
+            Utils::lz_decompress(payload, n_in, m_scratch.data(), raw);
+            Utils::byte_unshuffle(
+                m_scratch.data(), n, sizeof(T), reinterpret_cast<unsigned char*>(data));
+        }
+    }
+};
+
+} // namespace MpiWrapper
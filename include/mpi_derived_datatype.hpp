@@ -0,0 +1,135 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include <mpi.h>
+
+#include "mpi_datatype_base.hpp"
+#include "mpi_functions.hpp"
+
+namespace MpiWrapper {
+
+///
+///@brief Owning wrapper around a committed derived mpi-datatype. The type is move-only and is
+/// freed on destruction.
+///
+class DerivedDatatype : public MpiDatatypeBase<DerivedDatatype> {
+public:
+    DerivedDatatype()
+        : m_handle(MPI_DATATYPE_NULL) {}
+
+    ///
+    ///@brief Takes the ownership of the handle and commits it
+    ///
+    ///@param handle uncommitted derived datatype
+    ///
+    explicit DerivedDatatype(MPI_Datatype handle)
+        : m_handle(handle) {
+        int err = MPI_Type_commit(&m_handle);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Type_commit fails.");
+    }
+
+    DerivedDatatype(const DerivedDatatype& other) = delete;
+    DerivedDatatype& operator=(const DerivedDatatype& other) = delete;
+
+    DerivedDatatype(DerivedDatatype&& other) noexcept
+        : m_handle(other.m_handle) {
+        other.m_handle = MPI_DATATYPE_NULL;
+    }
+
+    DerivedDatatype& operator=(DerivedDatatype&& other) noexcept {
+        if (this != &other) {
+            free();
+            m_handle       = other.m_handle;
+            other.m_handle = MPI_DATATYPE_NULL;
+        }
+        return *this;
+    }
+
+    ~DerivedDatatype() { free(); }
+
+    ///
+    ///@brief Creates a subarray type (MPI_Type_create_subarray) of the block [starts, starts +
+    /// subsizes) of an N-dimensional array with the given sizes
+    ///
+    ///@param sizes extents of the full array
+    ///@param subsizes extents of the block
+    ///@param starts start indices of the block
+    ///@param base type of the array elements
+    ///@param order MPI_ORDER_C (last index fastest, default) or MPI_ORDER_FORTRAN
+    ///@return DerivedDatatype the committed type
+    ///
+    template <size_t N, class DT>
+    static DerivedDatatype subarray(const std::array<size_t, N>& sizes,
+                                    const std::array<size_t, N>& subsizes,
+                                    const std::array<size_t, N>& starts,
+                                    const MpiDatatypeBase<DT>&   base,
+                                    int                          order = MPI_ORDER_C) {
+        return DerivedDatatype(Mpi::type_create_subarray(sizes, subsizes, starts, order, ~base));
+    }
+
+    ///
+    ///@brief Creates a contiguous type (MPI_Type_contiguous) of count base elements
+    ///
+    ///@param count number of elements
+    ///@param base type of the elements
+    ///@return DerivedDatatype the committed type
+    ///
+    template <class DT>
+    static DerivedDatatype contiguous(int count, const MpiDatatypeBase<DT>& base) {
+        return DerivedDatatype(Mpi::type_contiguous(count, ~base));
+    }
+
+    ///
+    ///@brief Creates a type of equally sized blocks at the given displacements
+    /// (MPI_Type_create_indexed_block)
+    ///
+    ///@param blocklength number of elements per block
+    ///@param displs displacements of the blocks in elements
+    ///@param base type of the elements
+    ///@return DerivedDatatype the committed type
+    ///
+    template <class DT>
+    static DerivedDatatype indexed_block(int                        blocklength,
+                                         const std::vector<int>&    displs,
+                                         const MpiDatatypeBase<DT>& base) {
+        return DerivedDatatype(Mpi::type_create_indexed_block(
+            int(displs.size()), blocklength, displs.data(), ~base));
+    }
+
+    ///
+    ///@brief Creates a type of blocks with individual lengths at the given byte displacements
+    /// (MPI_Type_create_hindexed)
+    ///
+    ///@param blocklengths number of elements of each block
+    ///@param displs displacements of the blocks in bytes
+    ///@param base type of the elements
+    ///@return DerivedDatatype the committed type
+    ///
+    template <class DT>
+    static DerivedDatatype hindexed(const std::vector<int>&      blocklengths,
+                                    const std::vector<MPI_Aint>& displs,
+                                    const MpiDatatypeBase<DT>&   base) {
+        Utils::runtime_assert(blocklengths.size() == displs.size(), "Block count mismatch.");
+        return DerivedDatatype(Mpi::type_create_hindexed(
+            int(displs.size()), blocklengths.data(), displs.data(), ~base));
+    }
+
+    ///
+    ///@brief Get the mpi-handle
+    ///
+    ///@return MPI_Datatype handle
+    ///
+    MPI_Datatype get_handle() const { return m_handle; }
+
+private:
+    MPI_Datatype m_handle;
+
+    void free() {
+        if (m_handle != MPI_DATATYPE_NULL && !Mpi::finalized()) { Mpi::type_free(m_handle); }
+        m_handle = MPI_DATATYPE_NULL;
+    }
+};
+
+} // namespace MpiWrapper
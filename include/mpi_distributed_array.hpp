@@ -0,0 +1,545 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include "aligned_allocator.hpp"
+#include "block_partition.hpp"
+#include "mpi_buffer_pool.hpp"
+#include "mpi_cart_communicator.hpp"
+#include "mpi_derived_datatype.hpp"
+#include "mpi_functions.hpp"
+#include "mpi_native_datatypes.hpp"
+#include "mpi_request.hpp"
+#include "pack_engine.hpp"
+#include "runtime_assert.hpp"
+
+namespace MpiWrapper {
+
+///
+///@brief How DistributedArray::exchange_ghosts() handles the non-contiguous halos: Datatype
+/// hands subarray datatypes to MPI, Engine packs them in user space (Utils::pack) and sends
+/// contiguous buffers.
+///
+enum class HaloPacking { Datatype, Engine };
+
+///
+///@brief N-dimensional array distributed as one block per process of a Cartesian topology. Each
+/// process owns its block surrounded by ghost_width layers of ghost cells in every direction.
+///
+/// The local storage is in C order (last index fastest) and starts at a cache line boundary. In
+/// the last direction the rows are padded so that the first interior element of every row is
+/// cache line aligned and the row pitch is a multiple of the cache line. Local indices are
+/// relative to the first interior element, i.e. ghost cells have indices -ghost_width..-1 and
+/// local_extents()..local_extents() + ghost_width - 1.
+///
+///@tparam T element type, requires an MpiDatatype<T> specialization
+///@tparam N number of dimensions
+///
+template <class T, size_t N> class DistributedArray {
+public:
+    using index_type = std::array<int, N>;
+
+    ///
+    ///@brief Construct a new Distributed Array object with the global extents split into nearly
+    /// equal blocks, collective over the communicator
+    ///
+    ///@param comm the Cartesian topology, the periods determine the ghost exchange at the
+    /// boundaries
+    ///@param global_extents number of global points in each direction
+    ///@param ghost_width number of ghost layers, default = 0
+    ///
+    DistributedArray(const CartCommunicator<N>&   comm,
+                     const std::array<size_t, N>& global_extents,
+                     size_t                       ghost_width = 0)
+        : m_comm(comm)
+        , m_global(global_extents)
+        , m_ghost(ghost_width) {
+
+        auto dims = m_comm.get_topology_dims();
+        for (size_t d = 0; d < N; ++d) {
+            m_bounds[d].resize(dims[d] + 1);
+            for (size_t c = 0; c <= dims[d]; ++c) {
+                m_bounds[d][c] = Utils::block_offset(m_global[d], dims[d], c);
+            }
+        }
+        init();
+    }
+
+    ///
+    ///@brief Construct a new Distributed Array object with a non-uniform (tensor-product) partition,
+    /// collective over the communicator
+    ///
+    ///@param comm the Cartesian topology
+    ///@param bounds partition boundaries in each direction, the process with coordinate c in
+    /// direction d owns the global indices [bounds[d][c], bounds[d][c + 1]). The first boundary
+    /// is 0 and the last one the global extent.
+    ///@param ghost_width number of ghost layers, default = 0
+    ///
+    DistributedArray(const CartCommunicator<N>&                comm,
+                     const std::array<std::vector<size_t>, N>& bounds,
+                     size_t                                    ghost_width = 0)
+        : m_comm(comm)
+        , m_ghost(ghost_width)
+        , m_bounds(bounds) {
+
+        auto dims = m_comm.get_topology_dims();
+        for (size_t d = 0; d < N; ++d) {
+            Utils::runtime_assert(m_bounds[d].size() == dims[d] + 1 && m_bounds[d].front() == 0,
+                                  "Partition boundaries do not match the topology.");
+            Utils::runtime_assert(std::is_sorted(m_bounds[d].begin(), m_bounds[d].end()),
+                                  "Partition boundaries not sorted.");
+            m_global[d] = m_bounds[d].back();
+        }
+        init();
+    }
+
+    ///
+    ///@brief Get the communicator
+    ///
+    ///@return const CartCommunicator<N>&
+    ///
+    const CartCommunicator<N>& get_communicator() const { return m_comm; }
+
+    ///
+    ///@brief Get the global extents
+    ///
+    ///@return std::array<size_t, N> number of global points in each direction
+    ///
+    std::array<size_t, N> global_extents() const { return m_global; }
+
+    ///
+    ///@brief Get the extents of the local block (without ghosts)
+    ///
+    ///@return std::array<size_t, N> number of local points in each direction
+    ///
+    std::array<size_t, N> local_extents() const { return m_local; }
+
+    ///
+    ///@brief Get the global index of the first local (interior) point
+    ///
+    ///@return std::array<size_t, N> global offsets of the local block
+    ///
+    std::array<size_t, N> local_offsets() const { return m_offset; }
+
+    ///
+    ///@brief Get the number of ghost layers
+    ///
+    ///@return size_t ghost width
+    ///
+    size_t ghost_width() const { return m_ghost; }
+
+    ///
+    ///@brief Get the extents of the local storage including the ghosts and the row padding
+    ///
+    ///@return std::array<size_t, N> storage extents
+    ///
+    std::array<size_t, N> storage_extents() const { return m_storage; }
+
+    ///
+    ///@brief Get the storage index of the first interior element in each direction
+    ///
+    ///@return std::array<size_t, N> storage origin
+    ///
+    std::array<size_t, N> storage_origin() const { return m_origin; }
+
+    ///
+    ///@brief Get the element strides of the local storage
+    ///
+    ///@return std::array<size_t, N> strides, the last one is 1
+    ///
+    std::array<size_t, N> strides() const { return m_strides; }
+
+    ///
+    ///@brief Get the partition boundaries, the process with coordinate c in direction d owns the
+    /// global indices [bounds(d)[c], bounds(d)[c + 1])
+    ///
+    ///@param d direction
+    ///@return const std::vector<size_t>& boundaries
+    ///
+    const std::vector<size_t>& bounds(size_t d) const { return m_bounds[d]; }
+
+    ///
+    ///@brief Get the global offsets of the block of the process at the given topology coordinates
+    ///
+    ///@param coords topology coordinates
+    ///@return std::array<size_t, N> global offsets of the block
+    ///
+    std::array<size_t, N> block_offsets(const std::array<size_t, N>& coords) const {
+        std::array<size_t, N> ret;
+        for (size_t d = 0; d < N; ++d) { ret[d] = m_bounds[d][coords[d]]; }
+        return ret;
+    }
+
+    ///
+    ///@brief Get the extents of the block of the process at the given topology coordinates
+    ///
+    ///@param coords topology coordinates
+    ///@return std::array<size_t, N> extents of the block
+    ///
+    std::array<size_t, N> block_extents(const std::array<size_t, N>& coords) const {
+        std::array<size_t, N> ret;
+        for (size_t d = 0; d < N; ++d) {
+            ret[d] = m_bounds[d][coords[d] + 1] - m_bounds[d][coords[d]];
+        }
+        return ret;
+    }
+
+    ///
+    ///@brief Get the pointer to the beginning of the local storage (the first ghost element)
+    ///
+    ///@return T* storage pointer
+    ///
+    T*       data() { return m_data.data(); }
+    const T* data() const { return m_data.data(); }
+
+    ///
+    ///@brief Get the number of elements in the local storage
+    ///
+    ///@return size_t storage size
+    ///
+    size_t storage_size() const { return m_data.size(); }
+
+    ///
+    ///@brief Access an element with a local index
+    ///
+    ///@param idx local index relative to the first interior point, ghosts are negative or beyond
+    /// local_extents()
+    ///@return T& the element
+    ///
+    T&       operator()(const index_type& idx) { return m_data[linear_index(idx)]; }
+    const T& operator()(const index_type& idx) const { return m_data[linear_index(idx)]; }
+
+    ///
+    ///@brief Converts a local index to a global index
+    ///
+    ///@param idx local index
+    ///@return std::array<size_t, N> global index
+    ///
+    std::array<size_t, N> local_to_global(const index_type& idx) const {
+        std::array<size_t, N> ret;
+        for (size_t d = 0; d < N; ++d) { ret[d] = size_t(int(m_offset[d]) + idx[d]); }
+        return ret;
+    }
+
+    ///
+    ///@brief Converts a global index to a local index
+    ///
+    ///@param idx global index
+    ///@return index_type local index, outside the interior if the point is not owned
+    ///
+    index_type global_to_local(const std::array<size_t, N>& idx) const {
+        index_type ret;
+        for (size_t d = 0; d < N; ++d) { ret[d] = int(idx[d]) - int(m_offset[d]); }
+        return ret;
+    }
+
+    ///
+    ///@brief Creates the datatype selecting the interior of the local storage
+    ///
+    ///@return DerivedDatatype the subarray type of the local block
+    ///
+    DerivedDatatype interior_datatype() const {
+        return DerivedDatatype::subarray(m_storage, m_local, m_origin, MpiDatatype<T>());
+    }
+
+    ///
+    ///@brief Copies the interior into a contiguous C-order buffer of local_size() elements, one
+    /// row of the last direction at a time
+    ///
+    ///@param out the destination buffer
+    ///
+    void copy_interior(T* out) const {
+        if (local_size() == 0) { return; }
+        const size_t rows = local_size() / m_local[N - 1];
+        for (size_t r = 0; r < rows; ++r) {
+            // row index to the local index of its first element
+            index_type idx{};
+            size_t     rest = r;
+            for (size_t d = N - 1; d-- > 0;) {
+                idx[d] = int(rest % m_local[d]);
+                rest /= m_local[d];
+            }
+            std::copy_n(&m_data[linear_index(idx)], m_local[N - 1], out + r * m_local[N - 1]);
+        }
+    }
+
+    ///
+    ///@brief Fills the ghost layers from the neighbouring processes, collective over the
+    /// communicator. The directions are exchanged one after another and each exchange includes
+    /// the ghosts of the previous directions so that also the edge and corner ghosts are filled.
+    /// Ghosts at non-periodic boundaries are left untouched.
+    ///
+    ///
+    void exchange_ghosts() {
+
+        if (m_ghost == 0) { return; }
+
+        if (m_packing == HaloPacking::Engine) {
+            exchange_packed();
+            return;
+        }
+
+        for (size_t d = 0; d < N; ++d) {
+            const auto& t = m_halo_types[d];
+
+            // to the lower neighbour, from the upper neighbour
+            m_comm.send_recv(data(), 1, t[0], m_lower[d], data(), 1, t[1], m_upper[d]);
+            // to the upper neighbour, from the lower neighbour
+            m_comm.send_recv(data(), 1, t[2], m_upper[d], data(), 1, t[3], m_lower[d]);
+        }
+    }
+
+    ///
+    ///@brief Selects how exchange_ghosts() packs the halos, local. All processes should use the
+    /// same setting, the messages are identical in both modes.
+    ///
+    ///@param packing HaloPacking::Datatype (default) or HaloPacking::Engine
+    ///
+    void set_halo_packing(HaloPacking packing) { m_packing = packing; }
+
+    ///
+    ///@brief Get the packing used by exchange_ghosts()
+    ///
+    ///@return HaloPacking the packing mode
+    ///
+    HaloPacking halo_packing() const { return m_packing; }
+
+    ///
+    ///@brief Gathers the interior of every process into a global array on root. Meant for small
+    /// grids, e.g. output and testing.
+    ///
+    ///@param global buffer of all the global points in C order, only accessed on root
+    ///@param root the receiving rank, default = 0
+    ///
+    void gather_to_root(T* global, int root = 0) const {
+
+        std::vector<DerivedDatatype> types;
+        std::vector<Request>         requests;
+        types.reserve(size_t(m_comm.size()) + 1);
+        requests.reserve(size_t(m_comm.size()) + 1);
+
+        if (local_size() > 0) {
+            types.push_back(interior_datatype());
+            requests.push_back(m_comm.isend(data(), 1, types.back(), root));
+        }
+
+        if (m_comm.get_rank() == root) {
+            for (int r = 0; r < m_comm.size(); ++r) {
+                if (!rank_has_points(r)) { continue; }
+                types.push_back(global_block_datatype(r));
+                requests.push_back(m_comm.irecv(global, 1, types.back(), r));
+            }
+        }
+
+        for (auto& request : requests) { request.wait(); }
+    }
+
+    ///
+    ///@brief Scatters a global array from root to the interior of every process. Meant for small
+    /// grids, e.g. input and testing.
+    ///
+    ///@param global buffer of all the global points in C order, only accessed on root
+    ///@param root the sending rank, default = 0
+    ///
+    void scatter_from_root(const T* global, int root = 0) {
+
+        std::vector<DerivedDatatype> types;
+        std::vector<Request>         requests;
+        types.reserve(size_t(m_comm.size()) + 1);
+        requests.reserve(size_t(m_comm.size()) + 1);
+
+        if (local_size() > 0) {
+            types.push_back(interior_datatype());
+            requests.push_back(m_comm.irecv(data(), 1, types.back(), root));
+        }
+
+        if (m_comm.get_rank() == root) {
+            for (int r = 0; r < m_comm.size(); ++r) {
+                if (!rank_has_points(r)) { continue; }
+                types.push_back(global_block_datatype(r));
+                requests.push_back(m_comm.isend(global, 1, types.back(), r));
+            }
+        }
+
+        for (auto& request : requests) { request.wait(); }
+    }
+
+    ///
+    ///@brief Get the number of interior points of this process
+    ///
+    ///@return size_t number of local points
+    ///
+    size_t local_size() const {
+        size_t ret = 1;
+        for (auto e : m_local) { ret *= e; }
+        return ret;
+    }
+
+private:
+    CartCommunicator<N>                m_comm;
+    std::array<size_t, N>              m_global;
+    size_t                             m_ghost;
+    std::array<std::vector<size_t>, N> m_bounds;
+
+    std::array<size_t, N> m_local{};
+    std::array<size_t, N> m_offset{};
+    std::array<size_t, N> m_storage{};
+    std::array<size_t, N> m_origin{};
+    std::array<size_t, N> m_strides{};
+
+    std::vector<T, Utils::AlignedAllocator<T>> m_data;
+
+    // per direction: send lower slab, receive upper ghosts, send upper slab, receive lower ghosts
+    std::array<std::array<DerivedDatatype, 4>, N>          m_halo_types;
+    std::array<std::array<Utils::SubarrayLayout<N>, 4>, N> m_halo_layouts;
+    std::array<int, N>                                     m_lower{};
+    std::array<int, N>                                     m_upper{};
+
+    HaloPacking   m_packing = HaloPacking::Datatype;
+    PoolVector<T> m_send_buffer;
+    PoolVector<T> m_recv_buffer;
+
+    ///
+    ///@brief Sets up the local block, the storage and the ghost exchange from m_bounds
+    ///
+    ///
+    void init() {
+
+        auto coords = m_comm.get_coords();
+        m_local     = block_extents(coords);
+        m_offset    = block_offsets(coords);
+
+        // elements per cache line, no padding if the type does not divide the cache line
+        const size_t align =
+            Utils::cache_line_size % sizeof(T) == 0 ? Utils::cache_line_size / sizeof(T) : 1;
+
+        for (size_t d = 0; d + 1 < N; ++d) {
+            m_origin[d]  = m_ghost;
+            m_storage[d] = m_local[d] + 2 * m_ghost;
+        }
+        m_origin[N - 1]  = Utils::round_up(m_ghost, align);
+        m_storage[N - 1] = Utils::round_up(m_origin[N - 1] + m_local[N - 1] + m_ghost, align);
+
+        m_strides[N - 1] = 1;
+        for (size_t d = N - 1; d > 0; --d) { m_strides[d - 1] = m_strides[d] * m_storage[d]; }
+
+        m_data.assign(m_strides[0] * m_storage[0], T{});
+
+        if (m_ghost > 0) { init_halo(); }
+    }
+
+    ///
+    ///@brief Creates the datatypes and the neighbour ranks of the ghost exchange
+    ///
+    ///
+    void init_halo() {
+
+        for (size_t d = 0; d < N; ++d) {
+            Utils::runtime_assert(m_local[d] >= m_ghost, "Local block smaller than ghost width.");
+        }
+
+        for (size_t d = 0; d < N; ++d) {
+
+            std::array<int, N> dir{};
+            dir[d]     = 1;
+            auto nbrs  = m_comm.shift(dir);
+            m_upper[d] = nbrs.first;
+            m_lower[d] = nbrs.second;
+
+            std::array<size_t, N> starts, subsizes;
+            for (size_t e = 0; e < N; ++e) {
+                // ghosts of the already exchanged directions are included
+                starts[e]   = e < d ? m_origin[e] - m_ghost : m_origin[e];
+                subsizes[e] = e < d ? m_local[e] + 2 * m_ghost : m_local[e];
+            }
+            subsizes[d] = m_ghost;
+
+            const std::array<size_t, 4> slab_starts{m_origin[d],
+                                                    m_origin[d] + m_local[d],
+                                                    m_origin[d] + m_local[d] - m_ghost,
+                                                    m_origin[d] - m_ghost};
+
+            for (size_t i = 0; i < 4; ++i) {
+                starts[d]          = slab_starts[i];
+                m_halo_types[d][i] =
+                    DerivedDatatype::subarray(m_storage, subsizes, starts, MpiDatatype<T>());
+
+                auto& layout   = m_halo_layouts[d][i];
+                layout.extents = subsizes;
+                layout.strides = m_strides;
+                layout.offset  = 0;
+                for (size_t e = 0; e < N; ++e) { layout.offset += starts[e] * m_strides[e]; }
+            }
+        }
+    }
+
+    ///
+    ///@brief Ghost exchange with the user-space pack engine, the same messages as the datatype
+    /// path
+    ///
+    void exchange_packed() {
+
+        for (size_t d = 0; d < N; ++d) {
+            const auto& l = m_halo_layouts[d];
+            // the slabs of one direction have the same size
+            const size_t n = l[0].size();
+            if (m_send_buffer.size() < n) {
+                m_send_buffer.resize(n);
+                m_recv_buffer.resize(n);
+            }
+            const int count = int(n);
+
+            const std::array<std::array<int, 2>, 2> partners{
+                {{m_lower[d], m_upper[d]}, {m_upper[d], m_lower[d]}}};
+            for (size_t k = 0; k < 2; ++k) {
+                const int dest = partners[k][0], source = partners[k][1];
+                if (dest != MPI_PROC_NULL) {
+                    Utils::pack(data(), l[2 * k], m_send_buffer.data());
+                }
+                m_comm.send_recv(m_send_buffer.data(),
+                                 count,
+                                 MpiDatatype<T>(),
+                                 dest,
+                                 m_recv_buffer.data(),
+                                 count,
+                                 MpiDatatype<T>(),
+                                 source);
+                if (source != MPI_PROC_NULL) {
+                    Utils::unpack(m_recv_buffer.data(), l[2 * k + 1], data());
+                }
+            }
+        }
+    }
+
+    size_t linear_index(const index_type& idx) const {
+        size_t ret = 0;
+        for (size_t d = 0; d < N; ++d) {
+            ret += size_t(int(m_origin[d]) + idx[d]) * m_strides[d];
+        }
+        return ret;
+    }
+
+    std::array<size_t, N> rank_coords(int rank) const {
+        std::array<int, N> coords;
+        Mpi::cart_coords(m_comm.get_handle(), rank, int(N), coords.data());
+        return Utils::cast_to_uintarray(coords);
+    }
+
+    bool rank_has_points(int rank) const {
+        auto e = block_extents(rank_coords(rank));
+        for (auto n : e) {
+            if (n == 0) { return false; }
+        }
+        return true;
+    }
+
+    DerivedDatatype global_block_datatype(int rank) const {
+        auto coords = rank_coords(rank);
+        return DerivedDatatype::subarray(
+            m_global, block_extents(coords), block_offsets(coords), MpiDatatype<T>());
+    }
+};
+
+} // namespace MpiWrapper
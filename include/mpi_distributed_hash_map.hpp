@@ -0,0 +1,350 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "mpi_communicator.hpp"
+#include "mpi_derived_datatype.hpp"
+#include "mpi_functions.hpp"
+#include "mpi_native_datatypes.hpp"
+#include "mpi_window.hpp"
+#include "runtime_assert.hpp"
+
+namespace MpiWrapper {
+
+///
+///@brief Distributed hash map with the table spread over the processes in RMA windows, e.g. a
+/// global id to owner map of an unstructured mesh. Every key has a home process and a home
+/// bucket of bucket_size slots given by its hash, collisions probe the following buckets of the
+/// same process. There is no central directory: inserts claim slots with
+/// MPI_Compare_and_swap and lookups read whole buckets, both without involving the target
+/// process.
+///
+/// The operations work on batches. Each round issues one atomic per pending insert or one
+/// MPI_Get per owner process (an indexed datatype gathering the probed buckets of all the keys
+/// owned by that process) followed by a single flush, so the latency is paid per probing round
+/// and not per key.
+///
+/// Inserts and lookups are bulk-synchronous phases: inserts of other processes are guaranteed
+/// to be visible after a collective sync(). The optional read cache keeps the values found by
+/// find() and assumes that the value of a key does not change after it has been inserted.
+///
+///@tparam Key integer key type, std::numeric_limits<Key>::max() is reserved for empty slots
+///@tparam Value value type with an MpiDatatype made of a single predefined type, the values are
+/// written with MPI_Accumulate(MPI_REPLACE)
+///
+template <class Key, class Value> class DistributedHashMap {
+
+    static_assert(std::is_integral_v<Key>, "Keys have to be integers for the atomic inserts.");
+    static_assert(std::is_trivially_copyable_v<Value>, "Values have to be trivially copyable.");
+
+public:
+    ///
+    ///@brief The reserved key marking empty slots
+    ///
+    static constexpr Key empty_key = std::numeric_limits<Key>::max();
+
+    ///
+    ///@brief Construct a new Distributed Hash Map, collective over the communicator
+    ///
+    ///@param comm the communicator
+    ///@param local_capacity number of slots per process, rounded up to whole buckets
+    ///@param cache_capacity maximum number of cached entries, 0 disables the cache, default = 0
+    ///@param bucket_size number of slots read per probe, default = 8
+    ///
+    DistributedHashMap(const Communicator& comm,
+                       size_t              local_capacity,
+                       size_t              cache_capacity = 0,
+                       size_t              bucket_size    = 8)
+        : m_comm(comm)
+        , m_bucket_size(bucket_size)
+        , m_n_buckets((local_capacity + bucket_size - 1) / bucket_size)
+        , m_cache_capacity(cache_capacity)
+        , m_keys(comm, m_n_buckets * bucket_size)
+        , m_values(comm, m_n_buckets * bucket_size) {
+
+        Utils::runtime_assert(bucket_size > 0 && m_n_buckets > 0, "Invalid hash map capacity.");
+
+        std::fill_n(m_keys.data(), m_keys.size(), empty_key);
+        m_keys.lock_all();
+        m_keys.sync();
+        m_keys.unlock_all();
+        Mpi::barrier(m_comm.get_handle());
+    }
+
+    ///
+    ///@brief Inserts a batch of key-value pairs, existing keys get the new value. The pairs
+    /// become visible to the other processes after the next sync(). When several processes
+    /// insert the same key in one phase, the last write wins and the value is one of theirs. A key is dropped when all
+    /// the slots of its home process are taken by other keys.
+    ///
+    ///@param keys the keys, must not contain empty_key
+    ///@param values the values, same size as keys
+    ///@return std::vector<Key> the keys which have not been inserted because the table is full
+    ///
+    std::vector<Key> insert(const std::vector<Key>& keys, const std::vector<Value>& values) {
+
+        Utils::runtime_assert(keys.size() == values.size(), "Keys and values of different sizes.");
+
+        struct Pending {
+            size_t item;
+            int    owner;
+            size_t slot;
+            size_t probes;
+        };
+        std::vector<Pending> pending;
+        pending.reserve(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            Utils::runtime_assert(keys[i] != empty_key, "Reserved key inserted.");
+            auto [owner, bucket] = home(keys[i]);
+            pending.push_back({i, owner, bucket * m_bucket_size, 0});
+        }
+
+        const Key        empty = empty_key;
+        std::vector<Key> previous(pending.size());
+        std::vector<Key> failed;
+
+        m_keys.lock_all();
+        m_values.lock_all();
+        while (!pending.empty()) {
+
+            for (size_t p = 0; p < pending.size(); ++p) {
+                const auto& q = pending[p];
+                m_keys.compare_and_swap(&keys[q.item], &empty, &previous[p], q.owner, q.slot);
+            }
+            m_keys.flush_all();
+
+            size_t n_left = 0;
+            for (size_t p = 0; p < pending.size(); ++p) {
+                auto q = pending[p];
+                if (previous[p] == empty_key || previous[p] == keys[q.item]) {
+                    // atomic per element, concurrent inserts of the key do not mix bytes
+                    m_values.accumulate(&values[q.item], 1, q.owner, q.slot, MPI_REPLACE);
+                    continue;
+                }
+                // slot taken by another key, probe the next one until all have been tried
+                if (++q.probes == m_keys.size()) {
+                    failed.push_back(keys[q.item]);
+                    continue;
+                }
+                q.slot            = (q.slot + 1) % m_keys.size();
+                pending[n_left++] = q;
+            }
+            pending.resize(n_left);
+        }
+        m_values.unlock_all();
+        m_keys.unlock_all();
+        return failed;
+    }
+
+    ///
+    ///@brief Inserts a single key-value pair, see insert(keys, values)
+    ///
+    ///@param key the key
+    ///@param value the value
+    ///@return true if the pair has been inserted
+    ///@return false if the table of the home process is full
+    ///
+    bool insert(Key key, const Value& value) {
+        return insert(std::vector<Key>{key}, std::vector<Value>{value}).empty();
+    }
+
+    ///
+    ///@brief Looks up a batch of keys
+    ///
+    ///@param keys the keys to find
+    ///@return std::vector<std::optional<Value>> the values, empty for missing keys
+    ///
+    std::vector<std::optional<Value>> find(const std::vector<Key>& keys) {
+
+        std::vector<std::optional<Value>> ret(keys.size());
+
+        struct Pending {
+            size_t item;
+            int    owner;
+            size_t bucket;
+            size_t probes;
+        };
+        std::vector<Pending> pending;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (m_cache_capacity > 0) {
+                auto it = m_cache.find(keys[i]);
+                if (it != m_cache.end()) {
+                    ret[i] = it->second;
+                    continue;
+                }
+            }
+            auto [owner, bucket] = home(keys[i]);
+            pending.push_back({i, owner, bucket, 0});
+        }
+
+        // slots of the found keys
+        struct Found {
+            size_t item;
+            int    owner;
+            size_t slot;
+        };
+        std::vector<Found> found;
+
+        m_keys.lock_all();
+        std::vector<Key> buckets;
+        while (!pending.empty()) {
+
+            group_by_owner(pending);
+            buckets.resize(pending.size() * m_bucket_size);
+            std::vector<DerivedDatatype> types;
+            for_each_owner(pending, [&](int owner, size_t begin, size_t end) {
+                std::vector<int> displs;
+                for (size_t p = begin; p < end; ++p) {
+                    displs.push_back(int(pending[p].bucket * m_bucket_size));
+                }
+                types.push_back(DerivedDatatype::indexed_block(
+                    int(m_bucket_size), displs, MpiDatatype<Key>()));
+                m_keys.get(buckets.data() + begin * m_bucket_size,
+                           (end - begin) * m_bucket_size,
+                           owner,
+                           types.back());
+            });
+            m_keys.flush_all();
+
+            size_t n_left = 0;
+            for (size_t p = 0; p < pending.size(); ++p) {
+                auto       q     = pending[p];
+                const Key* slots = buckets.data() + p * m_bucket_size;
+                const Key* hit   = std::find(slots, slots + m_bucket_size, keys[q.item]);
+                if (hit != slots + m_bucket_size) {
+                    size_t slot = q.bucket * m_bucket_size + size_t(hit - slots);
+                    found.push_back({q.item, q.owner, slot});
+                    continue;
+                }
+                // an empty slot ends the probe sequence
+                if (std::find(slots, slots + m_bucket_size, empty_key) != slots + m_bucket_size) {
+                    continue;
+                }
+                if (++q.probes == m_n_buckets) { continue; }
+                q.bucket          = (q.bucket + 1) % m_n_buckets;
+                pending[n_left++] = q;
+            }
+            pending.resize(n_left);
+        }
+        m_keys.unlock_all();
+
+        // the values of the found keys, one get per owner
+        group_by_owner(found);
+        std::vector<Value>           values(found.size());
+        std::vector<DerivedDatatype> types;
+        m_values.lock_all();
+        for_each_owner(found, [&](int owner, size_t begin, size_t end) {
+            std::vector<int> displs;
+            for (size_t p = begin; p < end; ++p) { displs.push_back(int(found[p].slot)); }
+            types.push_back(DerivedDatatype::indexed_block(1, displs, MpiDatatype<Value>()));
+            m_values.get(values.data() + begin, end - begin, owner, types.back());
+        });
+        m_values.unlock_all();
+
+        for (size_t p = 0; p < found.size(); ++p) {
+            ret[found[p].item] = values[p];
+            cache(keys[found[p].item], values[p]);
+        }
+        return ret;
+    }
+
+    ///
+    ///@brief Looks up a single key, see find(keys)
+    ///
+    ///@param key the key to find
+    ///@return std::optional<Value> the value, empty if the key is missing
+    ///
+    std::optional<Value> find(Key key) { return find(std::vector<Key>{key})[0]; }
+
+    ///
+    ///@brief Ends an insert phase, collective over the communicator. Afterwards all the inserted
+    /// pairs are visible to all the processes.
+    ///
+    void sync() { Mpi::barrier(m_comm.get_handle()); }
+
+    ///
+    ///@brief Drops all the cached entries
+    ///
+    void clear_cache() { m_cache.clear(); }
+
+    ///
+    ///@brief Get the number of cached entries
+    ///
+    ///@return size_t number of entries in the read cache
+    ///
+    size_t cache_size() const { return m_cache.size(); }
+
+    ///
+    ///@brief Get the number of slots per process
+    ///
+    ///@return size_t the local capacity
+    ///
+    size_t local_capacity() const { return m_keys.size(); }
+
+    ///
+    ///@brief Get the home process of a key
+    ///
+    ///@param key the key
+    ///@return int the rank whose table holds the key
+    ///
+    int owner(Key key) const { return home(key).first; }
+
+private:
+    Communicator                   m_comm;
+    size_t                         m_bucket_size;
+    size_t                         m_n_buckets;
+    size_t                         m_cache_capacity;
+    Window<Key>                    m_keys;
+    Window<Value>                  m_values;
+    std::unordered_map<Key, Value> m_cache;
+
+    ///
+    ///@brief 64-bit finalizer of splitmix64, spreads consecutive ids over the processes
+    ///
+    static uint64_t mix(uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ull;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebull;
+        x ^= x >> 31;
+        return x;
+    }
+
+    std::pair<int, size_t> home(Key key) const {
+        uint64_t     h       = mix(uint64_t(key));
+        const size_t n_procs = size_t(m_comm.size());
+        return {int(h % n_procs), size_t((h / n_procs) % m_n_buckets)};
+    }
+
+    template <class Pending> static void group_by_owner(std::vector<Pending>& v) {
+        std::stable_sort(v.begin(), v.end(), [](const Pending& a, const Pending& b) {
+            return a.owner < b.owner;
+        });
+    }
+
+    template <class Pending, class Function>
+    static void for_each_owner(const std::vector<Pending>& v, Function f) {
+        for (size_t begin = 0; begin < v.size();) {
+            size_t end = begin;
+            while (end < v.size() && v[end].owner == v[begin].owner) { ++end; }
+            f(v[begin].owner, begin, end);
+            begin = end;
+        }
+    }
+
+    void cache(Key key, const Value& value) {
+        if (m_cache_capacity == 0) { return; }
+        // a full cache starts over, the hot keys are cached again by the next lookups
+        if (m_cache.size() >= m_cache_capacity) { m_cache.clear(); }
+        m_cache[key] = value;
+    }
+};
+
+} // namespace MpiWrapper
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+#include <mpi.h>
+
+#include "mpi_communicator.hpp"
+#include "mpi_datatype_base.hpp"
+#include "mpi_functions.hpp"
+#include "mpi_request.hpp"
+#include "runtime_assert.hpp"
+
+namespace MpiWrapper {
+
+///
+///@brief Tuning hints of the parallel file system and of the collective buffering of MPI-IO.
+/// Zero values are not set, the keys are reserved by MPI and ignored if not supported.
+///
+struct FileHints {
+    int    cb_nodes                   = 0;     // cb_nodes, number of aggregator processes
+    size_t cb_buffer_size             = 0;     // cb_buffer_size, aggregation buffer in bytes
+    int    striping_factor            = 0;     // striping_factor, number of storage targets
+    size_t striping_unit              = 0;     // striping_unit, stripe size in bytes
+    bool   force_collective_buffering = false; // romio_cb_write / romio_cb_read = enable
+
+    bool any() const {
+        return cb_nodes > 0 || cb_buffer_size > 0 || striping_factor > 0 || striping_unit > 0 ||
+               force_collective_buffering;
+    }
+};
+
+///
+///@brief Owning wrapper around a collectively opened MPI_File. The file is move-only and is
+/// closed on destruction. Striping hints only take effect when the file is created.
+///
+class File {
+public:
+    ///
+    ///@brief Opens a file, collective over the communicator. Throws std::runtime_error if the
+    /// file can not be opened.
+    ///
+    ///@param comm the communicator
+    ///@param path the file name
+    ///@param amode access mode, e.g. MPI_MODE_RDONLY or MPI_MODE_CREATE | MPI_MODE_WRONLY
+    ///@param hints tuning hints, default = none
+    ///
+    File(const Communicator& comm,
+         const std::string&  path,
+         int                 amode,
+         const FileHints&    hints = FileHints())
+        : m_comm(comm) {
+
+        if (hints.any()) {
+            MPI_Info info = make_info(hints);
+            m_handle      = Mpi::file_open(m_comm.get_handle(), path.c_str(), amode, info);
+            Mpi::info_free(info);
+        } else {
+            m_handle = Mpi::file_open(m_comm.get_handle(), path.c_str(), amode, MPI_INFO_NULL);
+        }
+        if (m_handle == MPI_FILE_NULL) { throw std::runtime_error("Can not open " + path + "."); }
+    }
+
+    ///
+    ///@brief Creates a file for writing, collective over the communicator. An existing file is
+    /// truncated.
+    ///
+    ///@param comm the communicator
+    ///@param path the file name
+    ///@param hints tuning hints, default = none
+    ///@return File the opened file
+    ///
+    static File
+    create(const Communicator& comm, const std::string& path, const FileHints& hints = FileHints()) {
+        File ret(comm, path, MPI_MODE_CREATE | MPI_MODE_WRONLY, hints);
+        Mpi::file_set_size(ret.m_handle, 0);
+        return ret;
+    }
+
+    ///
+    ///@brief Opens an existing file for reading, collective over the communicator
+    ///
+    ///@param comm the communicator
+    ///@param path the file name
+    ///@param hints tuning hints, default = none
+    ///@return File the opened file
+    ///
+    static File
+    open(const Communicator& comm, const std::string& path, const FileHints& hints = FileHints()) {
+        return File(comm, path, MPI_MODE_RDONLY, hints);
+    }
+
+    File(const File& other) = delete;
+    File& operator=(const File& other) = delete;
+
+    File(File&& other) noexcept
+        : m_comm(std::move(other.m_comm))
+        , m_handle(other.m_handle) {
+        other.m_handle = MPI_FILE_NULL;
+    }
+
+    File& operator=(File&& other) noexcept {
+        if (this != &other) {
+            close();
+            m_comm         = std::move(other.m_comm);
+            m_handle       = other.m_handle;
+            other.m_handle = MPI_FILE_NULL;
+        }
+        return *this;
+    }
+
+    ~File() { close(); }
+
+    ///
+    ///@brief Closes the file, collective over the communicator
+    ///
+    void close() {
+        if (m_handle != MPI_FILE_NULL && !Mpi::finalized()) { Mpi::file_close(m_handle); }
+        m_handle = MPI_FILE_NULL;
+    }
+
+    ///
+    ///@brief Sets the part of the file seen by this process, collective over the communicator
+    ///
+    ///@param disp offset of the view in bytes
+    ///@param etype elementary type of the file
+    ///@param filetype the part of the file seen by this process, tiled from disp
+    ///
+    template <class ET, class FT>
+    void set_view(MPI_Offset                 disp,
+                  const MpiDatatypeBase<ET>& etype,
+                  const MpiDatatypeBase<FT>& filetype) {
+        Mpi::file_set_view(m_handle, disp, ~etype, ~filetype, "native", MPI_INFO_NULL);
+    }
+
+    ///
+    ///@brief Collective write at the start of the view
+    ///
+    ///@param buffer the data
+    ///@param count number of memtypes
+    ///@param memtype layout of the data in memory
+    ///
+    template <class T, class DT>
+    void write_all(const T* buffer, int count, const MpiDatatypeBase<DT>& memtype) {
+        Mpi::file_write_all(m_handle, buffer, count, ~memtype);
+    }
+
+    ///
+    ///@brief Nonblocking collective write at the start of the view
+    ///
+    ///@param buffer the data, must stay alive until the request completes
+    ///@param count number of memtypes
+    ///@param memtype layout of the data in memory
+    ///@return Request the request of the write
+    ///
+    template <class T, class DT>
+    Request iwrite_all(const T* buffer, int count, const MpiDatatypeBase<DT>& memtype) {
+        return Request(Mpi::file_iwrite_all(m_handle, buffer, count, ~memtype));
+    }
+
+    ///
+    ///@brief Collective read from the start of the view
+    ///
+    ///@param buffer buffer for the data
+    ///@param count number of memtypes
+    ///@param memtype layout of the data in memory
+    ///
+    template <class T, class DT>
+    void read_all(T* buffer, int count, const MpiDatatypeBase<DT>& memtype) {
+        Mpi::file_read_all(m_handle, buffer, count, ~memtype);
+    }
+
+    ///
+    ///@brief Independent write by this process at an offset of the view, e.g. of a header
+    ///
+    ///@param offset offset in etypes of the view
+    ///@param buffer the data
+    ///@param count number of memtypes
+    ///@param memtype layout of the data in memory
+    ///
+    template <class T, class DT>
+    void
+    write_at(MPI_Offset offset, const T* buffer, int count, const MpiDatatypeBase<DT>& memtype) {
+        Mpi::file_write_at(m_handle, offset, buffer, count, ~memtype);
+    }
+
+    ///
+    ///@brief Independent read by this process at an offset of the view
+    ///
+    ///@param offset offset in etypes of the view
+    ///@param buffer buffer for the data
+    ///@param count number of memtypes
+    ///@param memtype layout of the data in memory
+    ///
+    template <class T, class DT>
+    void read_at(MPI_Offset offset, T* buffer, int count, const MpiDatatypeBase<DT>& memtype) {
+        Mpi::file_read_at(m_handle, offset, buffer, count, ~memtype);
+    }
+
+    ///
+    ///@brief Get the size of the file
+    ///
+    ///@return MPI_Offset size in bytes
+    ///
+    MPI_Offset size() const { return Mpi::file_get_size(m_handle); }
+
+    ///
+    ///@brief Get the communicator of the file
+    ///
+    ///@return const Communicator& the communicator
+    ///
+    const Communicator& get_communicator() const { return m_comm; }
+
+    ///
+    ///@brief Get the mpi-handle
+    ///
+    ///@return MPI_File handle
+    ///
+    MPI_File get_handle() const { return m_handle; }
+
+private:
+    Communicator m_comm;
+    MPI_File     m_handle = MPI_FILE_NULL;
+
+    static MPI_Info make_info(const FileHints& hints) {
+        MPI_Info info = Mpi::info_create();
+        if (hints.cb_nodes > 0) {
+            Mpi::info_set(info, "cb_nodes", std::to_string(hints.cb_nodes).c_str());
+        }
+        if (hints.cb_buffer_size > 0) {
+            Mpi::info_set(info, "cb_buffer_size", std::to_string(hints.cb_buffer_size).c_str());
+        }
+        if (hints.striping_factor > 0) {
+            Mpi::info_set(info, "striping_factor", std::to_string(hints.striping_factor).c_str());
+        }
+        if (hints.striping_unit > 0) {
+            Mpi::info_set(info, "striping_unit", std::to_string(hints.striping_unit).c_str());
+        }
+        if (hints.force_collective_buffering) {
+            Mpi::info_set(info, "romio_cb_write", "enable");
+            Mpi::info_set(info, "romio_cb_read", "enable");
+        }
+        return info;
+    }
+};
+
+} // namespace MpiWrapper
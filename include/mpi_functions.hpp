@@ -2,6 +2,7 @@
 
 #include <mpi.h>
 #include <numeric> //std::accumulate
+#include <string>
 #include "array_casts.hpp"
 #include "runtime_assert.hpp"
 
@@ -76,6 +77,263 @@ struct Mpi {
         Utils::runtime_assert(err == MPI_SUCCESS, "Mpi::free fails");
     }
 
+    ///
+    ///@brief Blocks until all the processes of the communicator have called it using
+    /// MPI_Barrier, can throw in debug mode.
+    ///
+    ///@param comm communicator handle
+    ///
+    static void barrier(MPI_Comm comm) {
+        int err = MPI_Barrier(comm);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Barrier fails.");
+    }
+
+    ///
+    ///@brief Duplicates the given communicator handle, throws on failure in debug mode.
+    ///
+    ///@param comm the handle to duplicate
+    ///@return MPI_Comm the new handle
+    ///
+    static MPI_Comm comm_dup(MPI_Comm comm) {
+        MPI_Comm new_handle;
+        int      err = MPI_Comm_dup(comm, &new_handle);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Comm_dup fails.");
+        return new_handle;
+    }
+
+    ///
+    ///@brief Duplicates the given communicator handle and attaches the info hints to the new
+    /// handle, throws on failure in debug mode.
+    ///
+    ///@param comm the handle to duplicate
+    ///@param info info object with the hints
+    ///@return MPI_Comm the new handle
+    ///
+    static MPI_Comm comm_dup_with_info(MPI_Comm comm, MPI_Info info) {
+        MPI_Comm new_handle;
+        int      err = MPI_Comm_dup_with_info(comm, info, &new_handle);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Comm_dup_with_info fails.");
+        return new_handle;
+    }
+
+    ///
+    ///@brief Partitions the communicator into disjoint sub-communicators using MPI_Comm_split,
+    /// throws on failure in debug mode.
+    ///
+    ///@param comm the handle to split
+    ///@param color processes with the same color end up in the same sub-communicator,
+    /// MPI_UNDEFINED gives MPI_COMM_NULL
+    ///@param key determines the rank order in the sub-communicator
+    ///@return MPI_Comm the new handle
+    ///
+    static MPI_Comm comm_split(MPI_Comm comm, int color, int key) {
+        MPI_Comm new_handle;
+        int      err = MPI_Comm_split(comm, color, key, &new_handle);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Comm_split fails.");
+        return new_handle;
+    }
+
+    ///
+    ///@brief Partitions the communicator by the given split type using MPI_Comm_split_type,
+    /// throws on failure in debug mode.
+    ///
+    ///@param comm the handle to split
+    ///@param split_type the type (e.g. MPI_COMM_TYPE_SHARED)
+    ///@param key determines the rank order in the sub-communicator
+    ///@return MPI_Comm the new handle
+    ///
+    static MPI_Comm comm_split_type(MPI_Comm comm, int split_type, int key) {
+        MPI_Comm new_handle;
+        int      err = MPI_Comm_split_type(comm, split_type, key, MPI_INFO_NULL, &new_handle);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Comm_split_type fails.");
+        return new_handle;
+    }
+
+    ///
+    ///@brief Get the group of the communicator, throws on failure in debug mode.
+    ///
+    ///@param comm the handle to query
+    ///@return MPI_Group the group, has to be freed with group_free
+    ///
+    static MPI_Group comm_group(MPI_Comm comm) {
+        MPI_Group group;
+        int       err = MPI_Comm_group(comm, &group);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Comm_group fails.");
+        return group;
+    }
+
+    ///
+    ///@brief Creates a subgroup consisting of the given ranks, throws on failure in debug mode.
+    ///
+    ///@param group the parent group
+    ///@param n number of ranks
+    ///@param ranks ranks (in the parent group) to include
+    ///@return MPI_Group the new group, has to be freed with group_free
+    ///
+    static MPI_Group group_incl(MPI_Group group, int n, const int* ranks) {
+        MPI_Group new_group;
+        int       err = MPI_Group_incl(group, n, ranks, &new_group);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Group_incl fails.");
+        return new_group;
+    }
+
+    ///
+    ///@brief Frees the group, throws on failure in debug mode.
+    ///
+    ///@param group the group to free
+    ///
+    static void group_free(MPI_Group group) {
+        int err = MPI_Group_free(&group);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Group_free fails.");
+    }
+
+    ///
+    ///@brief Creates a communicator of the group using MPI_Comm_create, collective over comm,
+    /// throws on failure in debug mode.
+    ///
+    ///@param comm the parent handle
+    ///@param group subgroup of the group of comm
+    ///@return MPI_Comm the new handle, MPI_COMM_NULL on processes not in the group
+    ///
+    static MPI_Comm comm_create(MPI_Comm comm, MPI_Group group) {
+        MPI_Comm new_handle;
+        int      err = MPI_Comm_create(comm, group, &new_handle);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Comm_create fails.");
+        return new_handle;
+    }
+
+    ///
+    ///@brief Creates a communicator of the group using MPI_Comm_create_group, collective only over
+    /// the members of the group, throws on failure in debug mode.
+    ///
+    ///@param comm the parent handle
+    ///@param group subgroup of the group of comm
+    ///@param tag tag to distinguish concurrent creations
+    ///@return MPI_Comm the new handle
+    ///
+    static MPI_Comm comm_create_group(MPI_Comm comm, MPI_Group group, int tag) {
+        MPI_Comm new_handle;
+        int      err = MPI_Comm_create_group(comm, group, tag, &new_handle);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Comm_create_group fails.");
+        return new_handle;
+    }
+
+    ///
+    ///@brief Get the largest tag value (MPI_TAG_UB) supported on the given communicator, throws on
+    /// failure in debug mode.
+    ///
+    ///@param comm the handle to query
+    ///@return int the upper bound of the tag values
+    ///
+    static int tag_ub(MPI_Comm comm) {
+        int* value;
+        int  flag;
+        int  err = MPI_Comm_get_attr(comm, MPI_TAG_UB, &value, &flag);
+        Utils::runtime_assert(err == MPI_SUCCESS && flag, "MPI_Comm_get_attr(MPI_TAG_UB) fails.");
+        return *value;
+    }
+
+    ///
+    ///@brief Allocates memory suitable for RMA and registered communication using MPI_Alloc_mem,
+    /// can throw in debug mode.
+    ///
+    ///@param size number of bytes
+    ///@param info allocation hints, e.g. MPI_INFO_NULL
+    ///@return void* the memory, to be freed with free_mem()
+    ///
+    static void* alloc_mem(size_t size, MPI_Info info) {
+        void* ptr = nullptr;
+        int   err = MPI_Alloc_mem(MPI_Aint(size), info, &ptr);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Alloc_mem fails.");
+        return ptr;
+    }
+
+    ///
+    ///@brief Frees memory of alloc_mem() using MPI_Free_mem, can throw in debug mode.
+    ///
+    ///@param ptr the memory
+    ///
+    static void free_mem(void* ptr) {
+        int err = MPI_Free_mem(ptr);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Free_mem fails.");
+    }
+
+    ///
+    ///@brief Creates an attribute key for communicators using MPI_Comm_create_keyval, can throw
+    /// in debug mode.
+    ///
+    ///@param copy_fn called when a communicator is duplicated, e.g. MPI_COMM_NULL_COPY_FN
+    ///@param delete_fn called when the attribute is deleted, e.g. MPI_COMM_NULL_DELETE_FN
+    ///@param extra_state passed to the callbacks
+    ///@return int the key
+    ///
+    static int comm_create_keyval(MPI_Comm_copy_attr_function*   copy_fn,
+                                  MPI_Comm_delete_attr_function* delete_fn,
+                                  void*                          extra_state) {
+        int keyval;
+        int err = MPI_Comm_create_keyval(copy_fn, delete_fn, &keyval, extra_state);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Comm_create_keyval fails.");
+        return keyval;
+    }
+
+    ///
+    ///@brief Frees an attribute key using MPI_Comm_free_keyval, can throw in debug mode. Attributes
+    /// still attached with the key keep working until they are deleted.
+    ///
+    ///@param keyval the key, set to MPI_KEYVAL_INVALID
+    ///
+    static void comm_free_keyval(int& keyval) {
+        int err = MPI_Comm_free_keyval(&keyval);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Comm_free_keyval fails.");
+    }
+
+    ///
+    ///@brief Attaches an attribute to a communicator using MPI_Comm_set_attr, can throw in debug
+    /// mode. An attribute of MPI_COMM_SELF is deleted at the beginning of MPI_Finalize.
+    ///
+    ///@param comm communicator handle
+    ///@param keyval the key
+    ///@param value the attribute
+    ///
+    static void comm_set_attr(MPI_Comm comm, int keyval, void* value) {
+        int err = MPI_Comm_set_attr(comm, keyval, value);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Comm_set_attr fails.");
+    }
+
+    ///
+    ///@brief Creates an empty info object, throws on failure in debug mode.
+    ///
+    ///@return MPI_Info the new info object
+    ///
+    static MPI_Info info_create() {
+        MPI_Info info;
+        int      err = MPI_Info_create(&info);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Info_create fails.");
+        return info;
+    }
+
+    ///
+    ///@brief Sets a key-value pair to the info object, throws on failure in debug mode.
+    ///
+    ///@param info the info object to modify
+    ///@param key the key
+    ///@param value the value
+    ///
+    static void info_set(MPI_Info info, const char* key, const char* value) {
+        int err = MPI_Info_set(info, key, value);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Info_set fails.");
+    }
+
+    ///
+    ///@brief Frees the info object, throws on failure in debug mode.
+    ///
+    ///@param info the info object to free
+    ///
+    static void info_free(MPI_Info info) {
+        int err = MPI_Info_free(&info);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Info_free fails.");
+    }
+
     ///
     ///@brief Get the rank of this process in the given handle, throws on failure in debug mode.
     ///
@@ -155,6 +413,353 @@ struct Mpi {
         Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Type_commit fails.");
     }
 
+    ///
+    ///@brief Creates an N-dimensional subarray datatype, throws on failure in debug mode. The
+    /// returned type is not committed.
+    ///
+    ///@param sizes extents of the full array
+    ///@param subsizes extents of the subarray
+    ///@param starts start indices of the subarray
+    ///@param order MPI_ORDER_C or MPI_ORDER_FORTRAN
+    ///@param base type of the array elements
+    ///@return MPI_Datatype the new datatype
+    ///
+    template <size_t N>
+    static MPI_Datatype type_create_subarray(const std::array<size_t, N>& sizes,
+                                             const std::array<size_t, N>& subsizes,
+                                             const std::array<size_t, N>& starts,
+                                             int                          order,
+                                             MPI_Datatype                 base) {
+
+        auto sizes_int    = Utils::cast_to_intarray(sizes);
+        auto subsizes_int = Utils::cast_to_intarray(subsizes);
+        auto starts_int   = Utils::cast_to_intarray(starts);
+
+        MPI_Datatype new_type;
+        int          err = MPI_Type_create_subarray(int(N),
+                                           sizes_int.data(),
+                                           subsizes_int.data(),
+                                           starts_int.data(),
+                                           order,
+                                           base,
+                                           &new_type);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Type_create_subarray fails.");
+        return new_type;
+    }
+
+    ///
+    ///@brief Queries the number of bytes of data in a datatype using MPI_Type_size, can throw in
+    /// debug mode.
+    ///
+    ///@param t the datatype
+    ///@return int size in bytes
+    ///
+    static int type_size(MPI_Datatype t) {
+        int size;
+        int err = MPI_Type_size(t, &size);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Type_size fails.");
+        return size;
+    }
+
+    ///
+    ///@brief Queries the name of a datatype using MPI_Type_get_name, e.g. "MPI_DOUBLE" for the
+    /// predefined types, can throw in debug mode.
+    ///
+    ///@param t the datatype
+    ///@return std::string the name, empty if none has been set
+    ///
+    static std::string type_get_name(MPI_Datatype t) {
+        char name[MPI_MAX_OBJECT_NAME];
+        int  length = 0;
+        int  err    = MPI_Type_get_name(t, name, &length);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Type_get_name fails.");
+        return std::string(name, size_t(length));
+    }
+
+    ///
+    ///@brief Creates a contiguous datatype of count base elements using MPI_Type_contiguous, can
+    /// throw in debug mode.
+    ///
+    ///@param count number of elements
+    ///@param base type of the elements
+    ///@return MPI_Datatype the new (uncommitted) datatype
+    ///
+    static MPI_Datatype type_contiguous(int count, MPI_Datatype base) {
+        MPI_Datatype new_type;
+        int          err = MPI_Type_contiguous(count, base, &new_type);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Type_contiguous fails.");
+        return new_type;
+    }
+
+    ///
+    ///@brief Creates a datatype of equally sized blocks at the given displacements using
+    /// MPI_Type_create_indexed_block, can throw in debug mode.
+    ///
+    ///@param count number of blocks
+    ///@param blocklength number of elements per block
+    ///@param displs displacements of the blocks in elements
+    ///@param base type of the elements
+    ///@return MPI_Datatype the new (uncommitted) datatype
+    ///
+    static MPI_Datatype
+    type_create_indexed_block(int count, int blocklength, const int* displs, MPI_Datatype base) {
+        MPI_Datatype new_type;
+        int err = MPI_Type_create_indexed_block(count, blocklength, displs, base, &new_type);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Type_create_indexed_block fails.");
+        return new_type;
+    }
+
+    ///
+    ///@brief Creates a datatype of blocks with individual lengths at the given byte
+    /// displacements using MPI_Type_create_hindexed, can throw in debug mode.
+    ///
+    ///@param count number of blocks
+    ///@param blocklengths number of elements of each block
+    ///@param displs displacements of the blocks in bytes
+    ///@param base type of the elements
+    ///@return MPI_Datatype the new (uncommitted) datatype
+    ///
+    static MPI_Datatype type_create_hindexed(int             count,
+                                             const int*      blocklengths,
+                                             const MPI_Aint* displs,
+                                             MPI_Datatype    base) {
+        MPI_Datatype new_type;
+        int err = MPI_Type_create_hindexed(count, blocklengths, displs, base, &new_type);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Type_create_hindexed fails.");
+        return new_type;
+    }
+
+    ///
+    ///@brief Creates a user-defined reduction operation using MPI_Op_create, can throw in debug
+    /// mode.
+    ///
+    ///@param function the reduction function
+    ///@param commute true if the operation is commutative
+    ///@return MPI_Op the new operation
+    ///
+    static MPI_Op op_create(MPI_User_function* function, bool commute) {
+        MPI_Op op;
+        int    err = MPI_Op_create(function, commute ? 1 : 0, &op);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Op_create fails.");
+        return op;
+    }
+
+    ///
+    ///@brief Frees a user-defined reduction operation, can throw in debug mode.
+    ///
+    ///@param op the operation to free
+    ///
+    static void op_free(MPI_Op op) {
+        int err = MPI_Op_free(&op);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Op_free fails.");
+    }
+
+    ///
+    ///@brief Combines the values of all processes and distributes the result using
+    /// MPI_Allreduce, can throw in debug mode.
+    ///
+    ///@param sendbuf data of this process (or MPI_IN_PLACE)
+    ///@param recvbuf buffer for the result
+    ///@param count number of elements
+    ///@param type type of the elements
+    ///@param op the reduction operation
+    ///@param comm communicator handle
+    ///
+    static void allreduce(
+        const void* sendbuf, void* recvbuf, int count, MPI_Datatype type, MPI_Op op, MPI_Comm comm) {
+        int err = MPI_Allreduce(sendbuf, recvbuf, count, type, op, comm);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Allreduce fails.");
+    }
+
+    ///
+    ///@brief Exclusive prefix reduction over the ranks using MPI_Exscan, can throw in debug mode.
+    /// The result on rank 0 is undefined.
+    ///
+    ///@param sendbuf data of this process
+    ///@param recvbuf buffer for the reduction of the data of the ranks below this one
+    ///@param count number of elements
+    ///@param type type of the elements
+    ///@param op the reduction operation
+    ///@param comm communicator handle
+    ///
+    static void exscan(
+        const void* sendbuf, void* recvbuf, int count, MPI_Datatype type, MPI_Op op, MPI_Comm comm) {
+        int err = MPI_Exscan(sendbuf, recvbuf, count, type, op, comm);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Exscan fails.");
+    }
+
+    ///
+    ///@brief Gathers the same amount of data from every process to every process using
+    /// MPI_Allgather, can throw in debug mode.
+    ///
+    ///@param sendbuf data of this process
+    ///@param sendcount number of sent elements
+    ///@param sendtype type of the sent elements
+    ///@param recvbuf buffer for the data of all the processes in rank order
+    ///@param recvcount number of elements received from each process
+    ///@param recvtype type of the received elements
+    ///@param comm communicator handle
+    ///
+    static void allgather(const void*  sendbuf,
+                          int          sendcount,
+                          MPI_Datatype sendtype,
+                          void*        recvbuf,
+                          int          recvcount,
+                          MPI_Datatype recvtype,
+                          MPI_Comm     comm) {
+        int err =
+            MPI_Allgather(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, comm);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Allgather fails.");
+    }
+
+    ///
+    ///@brief All-to-all exchange of the same amount of data between every pair of processes using
+    /// MPI_Alltoall, can throw in debug mode.
+    ///
+    ///@param sendbuf send buffer, one block per process in rank order
+    ///@param sendcount number of elements sent to each process
+    ///@param sendtype type of the sent elements
+    ///@param recvbuf receive buffer, one block per process in rank order
+    ///@param recvcount number of elements received from each process
+    ///@param recvtype type of the received elements
+    ///@param comm communicator handle
+    ///
+    static void alltoall(const void*  sendbuf,
+                         int          sendcount,
+                         MPI_Datatype sendtype,
+                         void*        recvbuf,
+                         int          recvcount,
+                         MPI_Datatype recvtype,
+                         MPI_Comm     comm) {
+        int err = MPI_Alltoall(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, comm);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Alltoall fails.");
+    }
+
+    ///
+    ///@brief Broadcasts data from the root to all processes using MPI_Bcast, can throw in debug
+    /// mode.
+    ///
+    ///@param buffer data on root, buffer for the data on the other processes
+    ///@param count number of elements
+    ///@param type type of the elements
+    ///@param root rank sending the data
+    ///@param comm communicator handle
+    ///
+    static void bcast(void* buffer, int count, MPI_Datatype type, int root, MPI_Comm comm) {
+        int err = MPI_Bcast(buffer, count, type, root, comm);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Bcast fails.");
+    }
+
+    ///
+    ///@brief Gathers the same amount of data from every process to the root using MPI_Gather, can
+    /// throw in debug mode.
+    ///
+    ///@param sendbuf data of this process
+    ///@param sendcount number of sent elements
+    ///@param sendtype type of the sent elements
+    ///@param recvbuf buffer for the data of all the processes in rank order, only used on root
+    ///@param recvcount number of elements received from each process
+    ///@param recvtype type of the received elements
+    ///@param root rank receiving the data
+    ///@param comm communicator handle
+    ///
+    static void gather(const void*  sendbuf,
+                       int          sendcount,
+                       MPI_Datatype sendtype,
+                       void*        recvbuf,
+                       int          recvcount,
+                       MPI_Datatype recvtype,
+                       int          root,
+                       MPI_Comm     comm) {
+        int err =
+            MPI_Gather(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, root, comm);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Gather fails.");
+    }
+
+    ///
+    ///@brief Gathers a varying amount of data from every process to the root using MPI_Gatherv,
+    /// can throw in debug mode.
+    ///
+    ///@param sendbuf data of this process
+    ///@param sendcount number of sent elements
+    ///@param sendtype type of the sent elements
+    ///@param recvbuf receive buffer, only used on root
+    ///@param recvcounts number of elements received from each process, only used on root
+    ///@param displs displacements in elements of the incoming blocks, only used on root
+    ///@param recvtype type of the received elements
+    ///@param root rank receiving the data
+    ///@param comm communicator handle
+    ///
+    static void gatherv(const void*  sendbuf,
+                        int          sendcount,
+                        MPI_Datatype sendtype,
+                        void*        recvbuf,
+                        const int*   recvcounts,
+                        const int*   displs,
+                        MPI_Datatype recvtype,
+                        int          root,
+                        MPI_Comm     comm) {
+        int err = MPI_Gatherv(
+            sendbuf, sendcount, sendtype, recvbuf, recvcounts, displs, recvtype, root, comm);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Gatherv fails.");
+    }
+
+    ///
+    ///@brief All-to-all exchange with a varying amount of data per process using MPI_Alltoallv,
+    /// can throw in debug mode.
+    ///
+    ///@param sendbuf send buffer
+    ///@param sendcounts number of elements sent to each process
+    ///@param sdispls displacements in elements of the outgoing blocks
+    ///@param sendtype type of the sent elements
+    ///@param recvbuf receive buffer
+    ///@param recvcounts number of elements received from each process
+    ///@param rdispls displacements in elements of the incoming blocks
+    ///@param recvtype type of the received elements
+    ///@param comm communicator handle
+    ///
+    static void alltoallv(const void*  sendbuf,
+                          const int*   sendcounts,
+                          const int*   sdispls,
+                          MPI_Datatype sendtype,
+                          void*        recvbuf,
+                          const int*   recvcounts,
+                          const int*   rdispls,
+                          MPI_Datatype recvtype,
+                          MPI_Comm     comm) {
+        int err = MPI_Alltoallv(
+            sendbuf, sendcounts, sdispls, sendtype, recvbuf, recvcounts, rdispls, recvtype, comm);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Alltoallv fails.");
+    }
+
+    ///
+    ///@brief All-to-all exchange where every block can have its own datatype using
+    /// MPI_Alltoallw, can throw in debug mode.
+    ///
+    ///@param sendbuf send buffer
+    ///@param sendcounts number of sendtypes sent to each process
+    ///@param sdispls displacements in bytes of the outgoing blocks
+    ///@param sendtypes datatypes of the outgoing blocks
+    ///@param recvbuf receive buffer
+    ///@param recvcounts number of recvtypes received from each process
+    ///@param rdispls displacements in bytes of the incoming blocks
+    ///@param recvtypes datatypes of the incoming blocks
+    ///@param comm communicator handle
+    ///
+    static void alltoallw(const void*         sendbuf,
+                          const int*          sendcounts,
+                          const int*          sdispls,
+                          const MPI_Datatype* sendtypes,
+                          void*               recvbuf,
+                          const int*          recvcounts,
+                          const int*          rdispls,
+                          const MPI_Datatype* recvtypes,
+                          MPI_Comm            comm) {
+        int err = MPI_Alltoallw(
+            sendbuf, sendcounts, sdispls, sendtypes, recvbuf, recvcounts, rdispls, recvtypes, comm);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Alltoallw fails.");
+    }
+
     ///
     ///@brief Call mpi abort on the given communicator
     ///
@@ -261,6 +866,675 @@ struct Mpi {
         Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Cart_rank fails.");
         return rank;
     }
+
+    ///
+    ///@brief Partitions the Cartesian topology into lower dimensional sub-grids using
+    /// MPI_Cart_sub, can throw in debug mode.
+    ///
+    ///@param comm Cartesian topology handle
+    ///@param remain_dims 1 if the direction is kept in the sub-grid, 0 if it is dropped
+    ///@return MPI_Comm the handle of the sub-grid containing this process
+    ///
+    static MPI_Comm cart_sub(MPI_Comm comm, const int* remain_dims) {
+        Utils::runtime_assert(topo_test(comm), "No cartesian topology attached.");
+        MPI_Comm new_handle;
+        int      err = MPI_Cart_sub(comm, remain_dims, &new_handle);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Cart_sub fails.");
+        return new_handle;
+    }
+
+    ///
+    ///@brief Creates a distributed graph topology where each process specifies its own incoming
+    /// and outgoing edges using MPI_Dist_graph_create_adjacent, can throw in debug mode.
+    ///
+    ///@param old old handle (typically MPI_COMM_WORLD)
+    ///@param indegree number of incoming edges
+    ///@param sources ranks of the sources of the incoming edges
+    ///@param sourceweights weights of the incoming edges or MPI_UNWEIGHTED
+    ///@param outdegree number of outgoing edges
+    ///@param destinations ranks of the destinations of the outgoing edges
+    ///@param destweights weights of the outgoing edges or MPI_UNWEIGHTED
+    ///@param reorder whether to reorder or not
+    ///@return MPI_Comm the new handle with the graph topology attached
+    ///
+    static MPI_Comm dist_graph_create_adjacent(MPI_Comm   old,
+                                               int        indegree,
+                                               const int* sources,
+                                               const int* sourceweights,
+                                               int        outdegree,
+                                               const int* destinations,
+                                               const int* destweights,
+                                               size_t     reorder) {
+        MPI_Comm new_handle;
+        int      err = MPI_Dist_graph_create_adjacent(old,
+                                                 indegree,
+                                                 sources,
+                                                 sourceweights,
+                                                 outdegree,
+                                                 destinations,
+                                                 destweights,
+                                                 MPI_INFO_NULL,
+                                                 int(reorder),
+                                                 &new_handle);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Dist_graph_create_adjacent fails.");
+        return new_handle;
+    }
+
+    ///
+    ///@brief Get the number of neighbours of this process in the distributed graph topology, can
+    /// throw in debug mode.
+    ///
+    ///@param comm graph topology handle
+    ///@return indegree number of incoming edges
+    ///@return outdegree number of outgoing edges
+    ///@return bool true if the edges are weighted
+    ///
+    static bool dist_graph_neighbors_count(MPI_Comm comm, int& indegree, int& outdegree) {
+        int weighted;
+        int err = MPI_Dist_graph_neighbors_count(comm, &indegree, &outdegree, &weighted);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Dist_graph_neighbors_count fails.");
+        return weighted != 0;
+    }
+
+    ///
+    ///@brief Get the neighbours of this process in the distributed graph topology, can throw in
+    /// debug mode.
+    ///
+    ///@param comm graph topology handle
+    ///@param maxindegree size of sources and sourceweights
+    ///@param maxoutdegree size of destinations and destweights
+    ///@return sources the ranks of the incoming edges
+    ///@return sourceweights weights of the incoming edges (or MPI_UNWEIGHTED)
+    ///@return destinations the ranks of the outgoing edges
+    ///@return destweights weights of the outgoing edges (or MPI_UNWEIGHTED)
+    ///
+    static void dist_graph_neighbors(MPI_Comm comm,
+                                     int      maxindegree,
+                                     int*     sources,
+                                     int*     sourceweights,
+                                     int      maxoutdegree,
+                                     int*     destinations,
+                                     int*     destweights) {
+        int err = MPI_Dist_graph_neighbors(
+            comm, maxindegree, sources, sourceweights, maxoutdegree, destinations, destweights);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Dist_graph_neighbors fails.");
+    }
+
+    ///
+    ///@brief Exchanges a variable amount of data with every neighbour of the topology using
+    /// MPI_Neighbor_alltoallv, can throw in debug mode.
+    ///
+    ///@param sendbuf send buffer
+    ///@param sendcounts number of elements sent to each outgoing neighbour
+    ///@param sdispls displacements (in elements) of the outgoing data
+    ///@param sendtype type of the sent elements
+    ///@param recvbuf receive buffer
+    ///@param recvcounts number of elements received from each incoming neighbour
+    ///@param rdispls displacements (in elements) of the incoming data
+    ///@param recvtype type of the received elements
+    ///@param comm handle with a topology attached
+    ///
+    static void neighbor_alltoallv(const void*  sendbuf,
+                                   const int*   sendcounts,
+                                   const int*   sdispls,
+                                   MPI_Datatype sendtype,
+                                   void*        recvbuf,
+                                   const int*   recvcounts,
+                                   const int*   rdispls,
+                                   MPI_Datatype recvtype,
+                                   MPI_Comm     comm) {
+        int err = MPI_Neighbor_alltoallv(
+            sendbuf, sendcounts, sdispls, sendtype, recvbuf, recvcounts, rdispls, recvtype, comm);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Neighbor_alltoallv fails.");
+    }
+
+    ///
+    ///@brief Starts a nonblocking standard mode send, can throw in debug mode.
+    ///
+    ///@param buffer send buffer
+    ///@param count number of elements to send
+    ///@param type datatype of the elements
+    ///@param dest rank of the destination
+    ///@param tag message tag
+    ///@param comm communicator handle
+    ///@return MPI_Request handle of the started send
+    ///
+    static MPI_Request
+    isend(const void* buffer, int count, MPI_Datatype type, int dest, int tag, MPI_Comm comm) {
+        MPI_Request request;
+        int         err = MPI_Isend(buffer, count, type, dest, tag, comm, &request);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Isend fails.");
+        return request;
+    }
+
+    ///
+    ///@brief Starts a nonblocking receive, can throw in debug mode.
+    ///
+    ///@param buffer receive buffer
+    ///@param count maximum number of elements to receive
+    ///@param type datatype of the elements
+    ///@param source rank of the source
+    ///@param tag message tag
+    ///@param comm communicator handle
+    ///@return MPI_Request handle of the started receive
+    ///
+    static MPI_Request
+    irecv(void* buffer, int count, MPI_Datatype type, int source, int tag, MPI_Comm comm) {
+        MPI_Request request;
+        int         err = MPI_Irecv(buffer, count, type, source, tag, comm, &request);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Irecv fails.");
+        return request;
+    }
+
+    ///
+    ///@brief Blocking standard mode send, can throw in debug mode.
+    ///
+    ///@param buffer send buffer
+    ///@param count number of elements to send
+    ///@param type datatype of the elements
+    ///@param dest rank of the destination
+    ///@param tag message tag
+    ///@param comm communicator handle
+    ///
+    static void
+    send(const void* buffer, int count, MPI_Datatype type, int dest, int tag, MPI_Comm comm) {
+        int err = MPI_Send(buffer, count, type, dest, tag, comm);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Send fails.");
+    }
+
+    ///
+    ///@brief Blocking receive, can throw in debug mode.
+    ///
+    ///@param buffer receive buffer
+    ///@param count maximum number of elements to receive
+    ///@param type datatype of the elements
+    ///@param source rank of the source
+    ///@param tag message tag
+    ///@param comm communicator handle
+    ///
+    static void
+    recv(void* buffer, int count, MPI_Datatype type, int source, int tag, MPI_Comm comm) {
+        int err = MPI_Recv(buffer, count, type, source, tag, comm, MPI_STATUS_IGNORE);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Recv fails.");
+    }
+
+    ///
+    ///@brief Blocks until a matching message is available without receiving it using MPI_Probe,
+    /// can throw in debug mode.
+    ///
+    ///@param source rank of the source or MPI_ANY_SOURCE
+    ///@param tag message tag or MPI_ANY_TAG
+    ///@param comm communicator handle
+    ///@return MPI_Status status of the message, e.g. for get_count()
+    ///
+    static MPI_Status probe(int source, int tag, MPI_Comm comm) {
+        MPI_Status status;
+        int        err = MPI_Probe(source, tag, comm, &status);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Probe fails.");
+        return status;
+    }
+
+    ///
+    ///@brief Queries the number of elements of a probed or received message using MPI_Get_count,
+    /// can throw in debug mode.
+    ///
+    ///@param status status of the message
+    ///@param type datatype of the elements
+    ///@return int number of elements
+    ///
+    static int get_count(const MPI_Status& status, MPI_Datatype type) {
+        int count;
+        int err = MPI_Get_count(&status, type, &count);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Get_count fails.");
+        return count;
+    }
+
+    ///
+    ///@brief Blocks until the request completes, can throw in debug mode. On return the request
+    /// is set to MPI_REQUEST_NULL.
+    ///
+    ///@param request the request to wait for
+    ///
+    static void wait(MPI_Request& request) {
+        int err = MPI_Wait(&request, MPI_STATUS_IGNORE);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Wait fails.");
+    }
+
+    ///
+    ///@brief Blocks until all the requests complete, can throw in debug mode.
+    ///
+    ///@param count number of requests
+    ///@param requests array of requests
+    ///
+    static void wait_all(int count, MPI_Request* requests) {
+        int err = MPI_Waitall(count, requests, MPI_STATUSES_IGNORE);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Waitall fails.");
+    }
+
+    ///
+    ///@brief Tests if the request has completed, can throw in debug mode.
+    ///
+    ///@param request the request to test
+    ///@return true if completed (request is set to MPI_REQUEST_NULL)
+    ///@return false if still pending
+    ///
+    static bool test(MPI_Request& request) {
+        int flag;
+        int err = MPI_Test(&request, &flag, MPI_STATUS_IGNORE);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Test fails.");
+        return flag != 0;
+    }
+
+    ///
+    ///@brief Tests a batch of requests at once using MPI_Testsome, can throw in debug mode.
+    ///
+    ///@param count number of requests
+    ///@param requests array of requests, completed entries are set to MPI_REQUEST_NULL
+    ///@param indices output array (at least count long) of indices of the completed requests
+    ///@return int number of completed requests, MPI_UNDEFINED if no active requests
+    ///
+    static int test_some(int count, MPI_Request* requests, int* indices) {
+        int outcount;
+        int err = MPI_Testsome(count, requests, &outcount, indices, MPI_STATUSES_IGNORE);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Testsome fails.");
+        return outcount;
+    }
+
+    ///
+    ///@brief Allocates memory and creates a window over it using MPI_Win_allocate, can throw in
+    /// debug mode.
+    ///
+    ///@param size size of the local window in bytes
+    ///@param disp_unit displacement unit in bytes
+    ///@param info info object with hints
+    ///@param comm communicator handle
+    ///@param baseptr output, the allocated memory
+    ///@return MPI_Win the window
+    ///
+    static MPI_Win
+    win_allocate(MPI_Aint size, int disp_unit, MPI_Info info, MPI_Comm comm, void* baseptr) {
+        MPI_Win win;
+        int     err = MPI_Win_allocate(size, disp_unit, info, comm, baseptr, &win);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Win_allocate fails.");
+        return win;
+    }
+
+    ///
+    ///@brief Frees a window and its memory, can throw in debug mode.
+    ///
+    ///@param win the window to free
+    ///
+    static void win_free(MPI_Win win) {
+        int err = MPI_Win_free(&win);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Win_free fails.");
+    }
+
+    ///
+    ///@brief Starts a shared passive-target epoch to all the processes using MPI_Win_lock_all, can
+    /// throw in debug mode.
+    ///
+    ///@param assert_flags assertions (e.g. MPI_MODE_NOCHECK)
+    ///@param win the window
+    ///
+    static void win_lock_all(int assert_flags, MPI_Win win) {
+        int err = MPI_Win_lock_all(assert_flags, win);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Win_lock_all fails.");
+    }
+
+    ///
+    ///@brief Ends the epoch started by win_lock_all, can throw in debug mode.
+    ///
+    ///@param win the window
+    ///
+    static void win_unlock_all(MPI_Win win) {
+        int err = MPI_Win_unlock_all(win);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Win_unlock_all fails.");
+    }
+
+    ///
+    ///@brief Starts a passive-target epoch to one process using MPI_Win_lock, can throw in debug
+    /// mode.
+    ///
+    ///@param lock_type MPI_LOCK_SHARED or MPI_LOCK_EXCLUSIVE
+    ///@param rank the target rank
+    ///@param assert_flags assertions (e.g. MPI_MODE_NOCHECK)
+    ///@param win the window
+    ///
+    static void win_lock(int lock_type, int rank, int assert_flags, MPI_Win win) {
+        int err = MPI_Win_lock(lock_type, rank, assert_flags, win);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Win_lock fails.");
+    }
+
+    ///
+    ///@brief Ends the epoch to one process started by win_lock, can throw in debug mode.
+    ///
+    ///@param rank the target rank
+    ///@param win the window
+    ///
+    static void win_unlock(int rank, MPI_Win win) {
+        int err = MPI_Win_unlock(rank, win);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Win_unlock fails.");
+    }
+
+    ///
+    ///@brief Completes all the outstanding operations to a target using MPI_Win_flush, can throw
+    /// in debug mode.
+    ///
+    ///@param rank the target rank
+    ///@param win the window
+    ///
+    static void win_flush(int rank, MPI_Win win) {
+        int err = MPI_Win_flush(rank, win);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Win_flush fails.");
+    }
+
+    ///
+    ///@brief Completes all the outstanding operations to all the targets using
+    /// MPI_Win_flush_all, can throw in debug mode.
+    ///
+    ///@param win the window
+    ///
+    static void win_flush_all(MPI_Win win) {
+        int err = MPI_Win_flush_all(win);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Win_flush_all fails.");
+    }
+
+    ///
+    ///@brief Completes the outstanding operations to a target at the origin only (the origin
+    /// buffers can be reused) using MPI_Win_flush_local, can throw in debug mode.
+    ///
+    ///@param rank the target rank
+    ///@param win the window
+    ///
+    static void win_flush_local(int rank, MPI_Win win) {
+        int err = MPI_Win_flush_local(rank, win);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Win_flush_local fails.");
+    }
+
+    ///
+    ///@brief Synchronizes the public and the private copy of the local window using
+    /// MPI_Win_sync, can throw in debug mode.
+    ///
+    ///@param win the window
+    ///
+    static void win_sync(MPI_Win win) {
+        int err = MPI_Win_sync(win);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Win_sync fails.");
+    }
+
+    ///
+    ///@brief Writes to the window of a target using MPI_Put, can throw in debug mode.
+    ///
+    ///@param origin local data
+    ///@param count number of elements
+    ///@param type type of the elements, both at the origin and at the target
+    ///@param rank the target rank
+    ///@param disp displacement in the target window in displacement units
+    ///@param win the window
+    ///
+    static void
+    put(const void* origin, int count, MPI_Datatype type, int rank, MPI_Aint disp, MPI_Win win) {
+        int err = MPI_Put(origin, count, type, rank, disp, count, type, win);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Put fails.");
+    }
+
+    ///
+    ///@brief Reads from the window of a target using MPI_Get, can throw in debug mode.
+    ///
+    ///@param origin local buffer for the data
+    ///@param count number of elements
+    ///@param type type of the elements, both at the origin and at the target
+    ///@param rank the target rank
+    ///@param disp displacement in the target window in displacement units
+    ///@param win the window
+    ///
+    static void get(void* origin, int count, MPI_Datatype type, int rank, MPI_Aint disp, MPI_Win win) {
+        int err = MPI_Get(origin, count, type, rank, disp, count, type, win);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Get fails.");
+    }
+
+    ///
+    ///@brief Combines local data into the window of a target using MPI_Accumulate, can throw in
+    /// debug mode.
+    ///
+    ///@param origin local data
+    ///@param count number of elements
+    ///@param type type of the elements, both at the origin and at the target
+    ///@param rank the target rank
+    ///@param disp displacement in the target window in displacement units
+    ///@param op the reduction operation (predefined only)
+    ///@param win the window
+    ///
+    static void accumulate(const void*  origin,
+                           int          count,
+                           MPI_Datatype type,
+                           int          rank,
+                           MPI_Aint     disp,
+                           MPI_Op       op,
+                           MPI_Win      win) {
+        int err = MPI_Accumulate(origin, count, type, rank, disp, count, type, op, win);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Accumulate fails.");
+    }
+
+    ///
+    ///@brief Reads from the window of a target using MPI_Get with different origin and target
+    /// layouts, can throw in debug mode.
+    ///
+    ///@param origin local buffer for the data
+    ///@param origin_count number of origin_types
+    ///@param origin_type layout of the local buffer
+    ///@param rank the target rank
+    ///@param disp displacement in the target window in displacement units
+    ///@param target_count number of target_types
+    ///@param target_type layout of the data in the target window
+    ///@param win the window
+    ///
+    static void get(void*        origin,
+                    int          origin_count,
+                    MPI_Datatype origin_type,
+                    int          rank,
+                    MPI_Aint     disp,
+                    int          target_count,
+                    MPI_Datatype target_type,
+                    MPI_Win      win) {
+        int err = MPI_Get(
+            origin, origin_count, origin_type, rank, disp, target_count, target_type, win);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Get fails.");
+    }
+
+    ///
+    ///@brief Atomically replaces an element of the window of a target if it equals compare using
+    /// MPI_Compare_and_swap, can throw in debug mode.
+    ///
+    ///@param origin the new value
+    ///@param compare the value to compare with
+    ///@param result output, the previous value of the target element
+    ///@param type type of the element, a predefined integer type
+    ///@param rank the target rank
+    ///@param disp displacement in the target window in displacement units
+    ///@param win the window
+    ///
+    static void compare_and_swap(const void*  origin,
+                                 const void*  compare,
+                                 void*        result,
+                                 MPI_Datatype type,
+                                 int          rank,
+                                 MPI_Aint     disp,
+                                 MPI_Win      win) {
+        int err = MPI_Compare_and_swap(origin, compare, result, type, rank, disp, win);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Compare_and_swap fails.");
+    }
+
+    ///
+    ///@brief Atomically combines a value into an element of the window of a target and returns
+    /// the previous value using MPI_Fetch_and_op, can throw in debug mode.
+    ///
+    ///@param origin the value to combine
+    ///@param result output, the previous value of the target element
+    ///@param type type of the element, a predefined type
+    ///@param rank the target rank
+    ///@param disp displacement in the target window in displacement units
+    ///@param op predefined reduction operation (MPI_NO_OP reads atomically)
+    ///@param win the window
+    ///
+    static void fetch_and_op(const void*  origin,
+                             void*        result,
+                             MPI_Datatype type,
+                             int          rank,
+                             MPI_Aint     disp,
+                             MPI_Op       op,
+                             MPI_Win      win) {
+        int err = MPI_Fetch_and_op(origin, result, type, rank, disp, op, win);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_Fetch_and_op fails.");
+    }
+
+    ///
+    ///@brief Opens a file collectively using MPI_File_open. File errors are expected at runtime
+    /// (e.g. a missing file) so the failure is returned instead of asserted.
+    ///
+    ///@param comm communicator handle
+    ///@param path the file name
+    ///@param amode access mode (MPI_MODE_RDONLY, MPI_MODE_CREATE | MPI_MODE_WRONLY, ...)
+    ///@param info info object with hints
+    ///@return MPI_File the file handle, MPI_FILE_NULL if the file can not be opened
+    ///
+    static MPI_File file_open(MPI_Comm comm, const char* path, int amode, MPI_Info info) {
+        MPI_File fh;
+        int      err = MPI_File_open(comm, path, amode, info, &fh);
+        return err == MPI_SUCCESS ? fh : MPI_FILE_NULL;
+    }
+
+    ///
+    ///@brief Closes a file collectively using MPI_File_close, can throw in debug mode.
+    ///
+    ///@param fh the file handle
+    ///
+    static void file_close(MPI_File fh) {
+        int err = MPI_File_close(&fh);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_File_close fails.");
+    }
+
+    ///
+    ///@brief Sets the view of the file for this process using MPI_File_set_view, can throw in
+    /// debug mode.
+    ///
+    ///@param fh the file handle
+    ///@param disp displacement of the view in bytes from the start of the file
+    ///@param etype elementary type
+    ///@param filetype the part of the file seen by this process
+    ///@param datarep data representation, e.g. "native"
+    ///@param info info object with hints
+    ///
+    static void file_set_view(MPI_File     fh,
+                              MPI_Offset   disp,
+                              MPI_Datatype etype,
+                              MPI_Datatype filetype,
+                              const char*  datarep,
+                              MPI_Info     info) {
+        int err = MPI_File_set_view(fh, disp, etype, filetype, datarep, info);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_File_set_view fails.");
+    }
+
+    ///
+    ///@brief Collective write at the current view position using MPI_File_write_all, can throw in
+    /// debug mode.
+    ///
+    ///@param fh the file handle
+    ///@param buf data to write
+    ///@param count number of elements
+    ///@param type layout of the data in memory
+    ///
+    static void file_write_all(MPI_File fh, const void* buf, int count, MPI_Datatype type) {
+        int err = MPI_File_write_all(fh, buf, count, type, MPI_STATUS_IGNORE);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_File_write_all fails.");
+    }
+
+    ///
+    ///@brief Collective read at the current view position using MPI_File_read_all, can throw in
+    /// debug mode.
+    ///
+    ///@param fh the file handle
+    ///@param buf buffer for the data
+    ///@param count number of elements
+    ///@param type layout of the data in memory
+    ///
+    static void file_read_all(MPI_File fh, void* buf, int count, MPI_Datatype type) {
+        int err = MPI_File_read_all(fh, buf, count, type, MPI_STATUS_IGNORE);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_File_read_all fails.");
+    }
+
+    ///
+    ///@brief Nonblocking collective write at the current view position using
+    /// MPI_File_iwrite_all, can throw in debug mode.
+    ///
+    ///@param fh the file handle
+    ///@param buf data to write, must stay alive until completion
+    ///@param count number of elements
+    ///@param type layout of the data in memory
+    ///@return MPI_Request the request of the write
+    ///
+    static MPI_Request file_iwrite_all(MPI_File fh, const void* buf, int count, MPI_Datatype type) {
+        MPI_Request request;
+        int         err = MPI_File_iwrite_all(fh, buf, count, type, &request);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_File_iwrite_all fails.");
+        return request;
+    }
+
+    ///
+    ///@brief Independent write at an offset of the view using MPI_File_write_at, can throw in
+    /// debug mode.
+    ///
+    ///@param fh the file handle
+    ///@param offset offset in etypes of the view
+    ///@param buf the data
+    ///@param count number of elements
+    ///@param type layout of the data in memory
+    ///
+    static void
+    file_write_at(MPI_File fh, MPI_Offset offset, const void* buf, int count, MPI_Datatype type) {
+        int err = MPI_File_write_at(fh, offset, buf, count, type, MPI_STATUS_IGNORE);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_File_write_at fails.");
+    }
+
+    ///
+    ///@brief Independent read at an offset of the view using MPI_File_read_at, can throw in debug
+    /// mode.
+    ///
+    ///@param fh the file handle
+    ///@param offset offset in etypes of the view
+    ///@param buf buffer for the data
+    ///@param count number of elements
+    ///@param type layout of the data in memory
+    ///
+    static void
+    file_read_at(MPI_File fh, MPI_Offset offset, void* buf, int count, MPI_Datatype type) {
+        int err = MPI_File_read_at(fh, offset, buf, count, type, MPI_STATUS_IGNORE);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_File_read_at fails.");
+    }
+
+    ///
+    ///@brief Queries the size of a file using MPI_File_get_size, can throw in debug mode.
+    ///
+    ///@param fh the file handle
+    ///@return MPI_Offset size in bytes
+    ///
+    static MPI_Offset file_get_size(MPI_File fh) {
+        MPI_Offset size;
+        int        err = MPI_File_get_size(fh, &size);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_File_get_size fails.");
+        return size;
+    }
+
+    ///
+    ///@brief Resizes a file collectively using MPI_File_set_size, can throw in debug mode.
+    ///
+    ///@param fh the file handle
+    ///@param size the new size in bytes
+    ///
+    static void file_set_size(MPI_File fh, MPI_Offset size) {
+        int err = MPI_File_set_size(fh, size);
+        Utils::runtime_assert(err == MPI_SUCCESS, "MPI_File_set_size fails.");
+    }
 };
 
 } // namespace MpiWrapper
\ No newline at end of file
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "mpi_communicator.hpp"
+#include "mpi_window.hpp"
+#include "runtime_assert.hpp"
+
+namespace MpiWrapper {
+
+///
+///@brief Global 64-bit counter stored in an RMA window on one process and updated with
+/// MPI_Fetch_and_op, e.g. for dynamic loop scheduling without a master process. The counter
+/// keeps a shared lock_all epoch open for its lifetime, every operation is one atomic followed
+/// by a flush. Contention on the root is reduced by grabbing whole chunks of indices at once.
+///
+class GlobalCounter {
+public:
+    ///
+    ///@brief Construct a new Global Counter, collective over the communicator
+    ///
+    ///@param comm the communicator
+    ///@param initial the initial value, default = 0
+    ///@param root rank holding the counter, default = 0
+    ///
+    explicit GlobalCounter(const Communicator& comm, int64_t initial = 0, int root = 0)
+        : m_root(root)
+        , m_window(comm, comm.get_rank() == root ? 1 : 0) {
+        if (comm.get_rank() == root) { m_window.data()[0] = initial; }
+        Mpi::barrier(comm.get_handle());
+        m_window.lock_all(MPI_MODE_NOCHECK);
+    }
+
+    GlobalCounter(const GlobalCounter& other) = delete;
+    GlobalCounter& operator=(const GlobalCounter& other) = delete;
+    GlobalCounter(GlobalCounter&& other)                 = delete;
+    GlobalCounter& operator=(GlobalCounter&& other) = delete;
+
+    ~GlobalCounter() {
+        if (!Mpi::finalized()) { m_window.unlock_all(); }
+    }
+
+    ///
+    ///@brief Atomically adds to the counter
+    ///
+    ///@param n the increment, may be negative
+    ///@return int64_t the value before the addition
+    ///
+    int64_t fetch_add(int64_t n) {
+        int64_t previous = 0;
+        m_window.fetch_and_op(&n, &previous, m_root, 0, MPI_SUM);
+        m_window.flush(m_root);
+        return previous;
+    }
+
+    ///
+    ///@brief Atomically reads the counter
+    ///
+    ///@return int64_t the current value
+    ///
+    int64_t load() {
+        int64_t unused = 0, value = 0;
+        m_window.fetch_and_op(&unused, &value, m_root, 0, MPI_NO_OP);
+        m_window.flush(m_root);
+        return value;
+    }
+
+    ///
+    ///@brief Grabs the next chunk of the index range [counter, limit), i.e. one iteration of a
+    /// dynamically scheduled loop over [initial, limit)
+    ///
+    ///@param chunk number of indices to grab
+    ///@param limit end of the index range
+    ///@param begin output, first index of the chunk
+    ///@param end output, end of the chunk
+    ///@return true if the chunk is not empty
+    ///@return false if the range is exhausted
+    ///
+    bool next_chunk(int64_t chunk, int64_t limit, int64_t& begin, int64_t& end) {
+        Utils::runtime_assert(chunk > 0, "Invalid chunk size.");
+        int64_t first = fetch_add(chunk);
+        begin         = std::min(first, limit);
+        end           = std::min(first + chunk, limit);
+        return begin < end;
+    }
+
+    ///
+    ///@brief Get the rank holding the counter
+    ///
+    ///@return int the root rank
+    ///
+    int root() const { return m_root; }
+
+private:
+    int             m_root;
+    Window<int64_t> m_window;
+};
+
+} // namespace MpiWrapper
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <numeric> //std::exclusive_scan
+#include <stdexcept>
+#include <vector>
+
+#include "mpi_communicator.hpp"
+#include "mpi_datatype_base.hpp"
+#include "mpi_functions.hpp"
+#include "runtime_assert.hpp"
+
+namespace MpiWrapper {
+
+///
+///@brief Communicator with a distributed graph topology (MPI_Dist_graph_create_adjacent) for
+/// unstructured neighbourhoods. Every process only specifies its own incoming and outgoing edges.
+/// The neighbour lists are queried once on construction so that they are given in the rank order
+/// of the (possibly reordered) new communicator.
+///
+class GraphCommunicator : public Communicator {
+public:
+    GraphCommunicator() = default;
+
+    ///
+    ///@brief Construct a new Graph Communicator object with unweighted edges
+    ///
+    ///@param sources ranks (in old) this process receives from
+    ///@param destinations ranks (in old) this process sends to
+    ///@param reorder whether to reorder the ranks or not 0/1, default = 1
+    ///@param old old communicator, default = Communicator() (i.e. MPI_COMM_WORLD)
+    ///
+    GraphCommunicator(const std::vector<int>& sources,
+                      const std::vector<int>& destinations,
+                      size_t                  reorder = 1,
+                      const Communicator&     old     = Communicator())
+        : Communicator(Mpi::dist_graph_create_adjacent(old.get_handle(),
+                                                       static_cast<int>(sources.size()),
+                                                       sources.data(),
+                                                       MPI_UNWEIGHTED,
+                                                       static_cast<int>(destinations.size()),
+                                                       destinations.data(),
+                                                       MPI_UNWEIGHTED,
+                                                       reorder)) {
+        cache_neighbours();
+    }
+
+    ///
+    ///@brief Construct a new Graph Communicator object with weighted edges. The weights describe
+    /// the communication volume and guide the rank placement when reorder = 1.
+    ///
+    ///@param sources ranks (in old) this process receives from
+    ///@param source_weights weights of the incoming edges
+    ///@param destinations ranks (in old) this process sends to
+    ///@param destination_weights weights of the outgoing edges
+    ///@param reorder whether to reorder the ranks or not 0/1, default = 1
+    ///@param old old communicator, default = Communicator() (i.e. MPI_COMM_WORLD)
+    ///
+    GraphCommunicator(const std::vector<int>& sources,
+                      const std::vector<int>& source_weights,
+                      const std::vector<int>& destinations,
+                      const std::vector<int>& destination_weights,
+                      size_t                  reorder = 1,
+                      const Communicator&     old     = Communicator())
+        : Communicator(Mpi::dist_graph_create_adjacent(old.get_handle(),
+                                                       static_cast<int>(sources.size()),
+                                                       sources.data(),
+                                                       checked_weights(source_weights, sources),
+                                                       static_cast<int>(destinations.size()),
+                                                       destinations.data(),
+                                                       checked_weights(destination_weights,
+                                                                       destinations),
+                                                       reorder)) {
+        cache_neighbours();
+    }
+
+    ///
+    ///@brief Get the ranks this process receives from
+    ///
+    ///@return const std::vector<int>& incoming neighbours
+    ///
+    const std::vector<int>& get_sources() const { return m_sources; }
+
+    ///
+    ///@brief Get the ranks this process sends to
+    ///
+    ///@return const std::vector<int>& outgoing neighbours
+    ///
+    const std::vector<int>& get_destinations() const { return m_destinations; }
+
+    ///
+    ///@brief Get the weights of the incoming edges, empty if the graph is unweighted
+    ///
+    ///@return const std::vector<int>& incoming weights
+    ///
+    const std::vector<int>& get_source_weights() const { return m_source_weights; }
+
+    ///
+    ///@brief Get the weights of the outgoing edges, empty if the graph is unweighted
+    ///
+    ///@return const std::vector<int>& outgoing weights
+    ///
+    const std::vector<int>& get_destination_weights() const { return m_destination_weights; }
+
+    ///
+    ///@brief Halo exchange with all the neighbours using one MPI_Neighbor_alltoallv. The data for
+    /// (from) the neighbours is packed contiguously in the order of get_destinations()
+    /// (get_sources()).
+    ///
+    ///@tparam T send and receive buffer type
+    ///@tparam DT datatype base class
+    ///@param send_buffer data sent to the outgoing neighbours
+    ///@param send_counts number of elements sent to each outgoing neighbour
+    ///@param type the mpi-datatype of the elements
+    ///@param recv_buffer buffer for the data of the incoming neighbours
+    ///@param recv_counts number of elements received from each incoming neighbour
+    ///
+    template <class T, class DT>
+    void halo_exchange(const T*                   send_buffer,
+                       const std::vector<int>&    send_counts,
+                       const MpiDatatypeBase<DT>& type,
+                       T*                         recv_buffer,
+                       const std::vector<int>&    recv_counts) const {
+
+        Utils::runtime_assert(send_counts.size() == m_destinations.size(),
+                              "Send counts do not match the destinations.");
+        Utils::runtime_assert(recv_counts.size() == m_sources.size(),
+                              "Receive counts do not match the sources.");
+
+        std::vector<int> sdispls(send_counts.size());
+        std::vector<int> rdispls(recv_counts.size());
+        std::exclusive_scan(send_counts.begin(), send_counts.end(), sdispls.begin(), 0);
+        std::exclusive_scan(recv_counts.begin(), recv_counts.end(), rdispls.begin(), 0);
+
+        Mpi::neighbor_alltoallv(send_buffer,
+                                send_counts.data(),
+                                sdispls.data(),
+                                ~type,
+                                recv_buffer,
+                                recv_counts.data(),
+                                rdispls.data(),
+                                ~type,
+                                this->get_handle());
+    }
+
+private:
+    std::vector<int> m_sources;
+    std::vector<int> m_destinations;
+    std::vector<int> m_source_weights;
+    std::vector<int> m_destination_weights;
+
+    ///
+    ///@brief Checks that there is one weight per neighbour before MPI reads the arrays, throws
+    /// std::invalid_argument otherwise
+    ///
+    static const int* checked_weights(const std::vector<int>& weights,
+                                      const std::vector<int>& neighbours) {
+        if (weights.size() != neighbours.size()) {
+            throw std::invalid_argument("Edge weights do not match the neighbours.");
+        }
+        return weights.empty() ? MPI_WEIGHTS_EMPTY : weights.data();
+    }
+
+    ///
+    ///@brief Queries the neighbours of this process in the new communicator
+    ///
+    ///
+    void cache_neighbours() {
+
+        int  indegree, outdegree;
+        bool weighted = Mpi::dist_graph_neighbors_count(this->get_handle(), indegree, outdegree);
+
+        m_sources.resize(size_t(indegree));
+        m_destinations.resize(size_t(outdegree));
+
+        if (weighted) {
+            m_source_weights.resize(size_t(indegree));
+            m_destination_weights.resize(size_t(outdegree));
+        }
+
+        Mpi::dist_graph_neighbors(this->get_handle(),
+                                  indegree,
+                                  m_sources.data(),
+                                  weighted ? weights_buffer(m_source_weights) : MPI_UNWEIGHTED,
+                                  outdegree,
+                                  m_destinations.data(),
+                                  weighted ? weights_buffer(m_destination_weights)
+                                           : MPI_UNWEIGHTED);
+    }
+
+    static int* weights_buffer(std::vector<int>& weights) {
+        return weights.empty() ? MPI_WEIGHTS_EMPTY : weights.data();
+    }
+};
+
+} // namespace MpiWrapper
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include "mpi_communicator.hpp"
+#include "mpi_distributed_array.hpp"
+#include "mpi_functions.hpp"
+#include "mpi_native_datatypes.hpp"
+#include "mpi_redistribution.hpp"
+#include "runtime_assert.hpp"
+
+namespace MpiWrapper {
+
+///
+///@brief Rebalances DistributedArrays with non-uniform tensor-product partitions. Every process
+/// reports a measured cost (e.g. the time spent in its block). The cost is assumed to be evenly
+/// spread over the points of the block and projected onto each direction, the new boundaries of
+/// a direction then split the projected cost into equal parts. The data is moved with a
+/// Redistribution plan, so the parts of the blocks that do not change owner stay in place.
+///
+class LoadBalancer {
+public:
+    ///
+    ///@brief Construct a new Load Balancer object
+    ///
+    ///@param threshold rebalance only if max cost / mean cost exceeds this, default = 1.1
+    ///@param relaxation fraction (0, 1] of the boundary movement applied per rebalance, values
+    /// below 1 migrate the data incrementally over several steps, default = 1
+    ///
+    explicit LoadBalancer(double threshold = 1.1, double relaxation = 1.0)
+        : m_threshold(threshold)
+        , m_relaxation(relaxation) {
+        Utils::runtime_assert(relaxation > 0.0 && relaxation <= 1.0, "Invalid relaxation.");
+    }
+
+    ///
+    ///@brief Computes the load imbalance, collective over the communicator
+    ///
+    ///@param comm the communicator
+    ///@param cost the cost of this process
+    ///@return double max cost / mean cost, 1 for a perfect balance
+    ///
+    static double imbalance(const Communicator& comm, double cost) {
+        double max_cost, sum_cost;
+        Mpi::allreduce(&cost, &max_cost, 1, MPI_DOUBLE, MPI_MAX, comm.get_handle());
+        Mpi::allreduce(&cost, &sum_cost, 1, MPI_DOUBLE, MPI_SUM, comm.get_handle());
+        if (sum_cost <= 0.0) { return 1.0; }
+        return max_cost * double(comm.size()) / sum_cost;
+    }
+
+    ///
+    ///@brief Computes the balanced partition boundaries, collective over the communicator of arr.
+    /// A direction with fewer than max(1, ghost width) points per process keeps its boundaries.
+    ///
+    ///@param arr the array with the current partition
+    ///@param cost the measured cost of this process
+    ///@return std::array<std::vector<size_t>, N> new boundaries of each direction
+    ///
+    template <class T, size_t N>
+    std::array<std::vector<size_t>, N> compute_bounds(const DistributedArray<T, N>& arr,
+                                                      double                        cost) const {
+
+        const auto& comm   = arr.get_communicator();
+        auto        dims   = comm.get_topology_dims();
+        auto        global = arr.global_extents();
+        auto        ext    = arr.local_extents();
+        auto        off    = arr.local_offsets();
+
+        // the blocks must not become thinner than the ghost layers, a direction too thin for that
+        // keeps its partition
+        const size_t min_size = std::max(size_t(1), arr.ghost_width());
+
+        std::array<std::vector<size_t>, N> ret;
+
+        for (size_t d = 0; d < N; ++d) {
+
+            if (global[d] < dims[d] * min_size) {
+                ret[d] = arr.bounds(d);
+                continue;
+            }
+
+            // cost per global index of direction d, summed over all the processes
+            std::vector<double> profile(global[d], 0.0);
+            if (ext[d] > 0) {
+                std::fill_n(profile.begin() + long(off[d]), ext[d], cost / double(ext[d]));
+            }
+            Mpi::allreduce(MPI_IN_PLACE,
+                           profile.data(),
+                           int(profile.size()),
+                           MPI_DOUBLE,
+                           MPI_SUM,
+                           comm.get_handle());
+
+            std::vector<double> prefix(global[d] + 1, 0.0);
+            for (size_t i = 0; i < global[d]; ++i) { prefix[i + 1] = prefix[i] + profile[i]; }
+
+            const auto& old   = arr.bounds(d);
+            const size_t parts = dims[d];
+            ret[d].assign(parts + 1, 0);
+            ret[d][parts] = global[d];
+
+            for (size_t c = 1; c < parts; ++c) {
+                double target = prefix.back() * double(c) / double(parts);
+                auto   it     = std::lower_bound(prefix.begin(), prefix.end(), target);
+                auto   ideal  = double(it - prefix.begin());
+
+                double moved = double(old[c]) + m_relaxation * (ideal - double(old[c]));
+                auto   b     = size_t(moved + 0.5);
+
+                // lo <= hi since global[d] >= parts * min_size
+                size_t lo = ret[d][c - 1] + min_size;
+                size_t hi = global[d] - (parts - c) * min_size;
+                ret[d][c] = std::clamp(b, lo, hi);
+            }
+        }
+        return ret;
+    }
+
+    ///
+    ///@brief Rebalances the array if the measured imbalance exceeds the threshold, collective over
+    /// the communicator of arr. On rebalance the interior data is migrated to the new partition
+    /// and the ghosts are exchanged.
+    ///
+    ///@param arr the array to rebalance
+    ///@param cost the measured cost of this process
+    ///@return true if the partition was changed
+    ///@return false if the imbalance was below the threshold
+    ///
+    template <class T, size_t N> bool rebalance(DistributedArray<T, N>& arr, double cost) const {
+
+        if (imbalance(arr.get_communicator(), cost) <= m_threshold) { return false; }
+
+        auto new_bounds = compute_bounds(arr, cost);
+
+        bool changed = false;
+        for (size_t d = 0; d < N; ++d) { changed = changed || new_bounds[d] != arr.bounds(d); }
+        if (!changed) { return false; }
+
+        DistributedArray<T, N> balanced(arr.get_communicator(), new_bounds, arr.ghost_width());
+        Redistribution<T, N>(arr, balanced).execute(arr, balanced);
+        balanced.exchange_ghosts();
+        arr = std::move(balanced);
+        return true;
+    }
+
+private:
+    double m_threshold;
+    double m_relaxation;
+};
+
+} // namespace MpiWrapper
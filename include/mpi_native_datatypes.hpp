@@ -1,5 +1,6 @@
 #pragma once
 
+#include <complex>
 #include <mpi.h>
 
 #include "mpi_datatype.hpp"
@@ -80,4 +81,16 @@ template <> struct MpiDatatype<bool> : MpiDatatypeBase<MpiDatatype<bool>> {
      static MPI_Datatype get_handle() { return MPI_C_BOOL; }
 };
 
+template <>
+struct MpiDatatype<std::complex<float>> : MpiDatatypeBase<MpiDatatype<std::complex<float>>> {
+
+     static MPI_Datatype get_handle() { return MPI_CXX_FLOAT_COMPLEX; }
+};
+
+template <>
+struct MpiDatatype<std::complex<double>> : MpiDatatypeBase<MpiDatatype<std::complex<double>>> {
+
+     static MPI_Datatype get_handle() { return MPI_CXX_DOUBLE_COMPLEX; }
+};
+
 } // namespace MpiWrapper
\ No newline at end of file
@@ -0,0 +1,347 @@
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <mpi.h>
+
+#include "mpi_buffer_pool.hpp"
+#include "mpi_communicator.hpp"
+#include "mpi_derived_datatype.hpp"
+#include "mpi_distributed_array.hpp"
+#include "mpi_file.hpp"
+#include "mpi_functions.hpp"
+#include "mpi_native_datatypes.hpp"
+#include "runtime_assert.hpp"
+
+namespace MpiWrapper {
+
+///
+///@brief Two-level I/O: the processes of a node are split into groups (MPI_Comm_split_type), each
+/// group ships its data to one aggregator process with MPI_Gatherv over the node-local
+/// communicator, i.e. through shared memory, and only the aggregators open the file and write
+/// large sorted pieces. This keeps the number of processes touching the file system, and the
+/// load on its metadata servers, at a few per node.
+///
+class NodeAggregator {
+public:
+    ///
+    ///@brief Construct a new Node Aggregator, collective over the communicator
+    ///
+    ///@param comm the communicator
+    ///@param aggregators_per_node number of writing processes per node, default = 1
+    ///
+    explicit NodeAggregator(const Communicator& comm, int aggregators_per_node = 1)
+        : m_comm(comm) {
+        Utils::runtime_assert(aggregators_per_node > 0, "Invalid number of aggregators.");
+
+        const int  rank      = m_comm.get_rank();
+        const auto node      = m_comm.split_type(MPI_COMM_TYPE_SHARED, rank);
+        const int  node_rank = node.get_rank();
+        const int  node_size = node.size();
+
+        // contiguous groups of node ranks, as equal as possible
+        const int n_groups = std::min(aggregators_per_node, node_size);
+        m_group            = node.split(node_rank * n_groups / node_size, node_rank);
+        m_is_aggregator    = m_group.get_rank() == 0;
+        m_aggregators      = m_comm.split(m_is_aggregator ? 0 : MPI_UNDEFINED, rank);
+
+        int mine = m_is_aggregator ? 1 : 0;
+        Mpi::allreduce(MPI_IN_PLACE, &mine, 1, MPI_INT, MPI_SUM, m_comm.get_handle());
+        m_n_aggregators = mine;
+    }
+
+    ///
+    ///@brief Writes pieces of bytes to a file, collective over the communicator. The file is
+    /// created (and truncated) by the aggregators only and is complete when the call returns.
+    /// The pieces of all processes must not overlap.
+    ///
+    /// An aggregator receives at most round_bytes() bytes at a time (MPI counts are int, so at
+    /// most INT_MAX): every process ships at most round_bytes() / group size bytes per round,
+    /// pieces are split as needed, and the rounds are repeated until all the data is written.
+    ///
+    ///@param path the file name
+    ///@param offsets file offsets of the pieces in bytes
+    ///@param lengths lengths of the pieces in bytes
+    ///@param data the pieces one after another
+    ///@param hints tuning hints of the file, default = none
+    ///
+    void write(const std::string&          path,
+               const std::vector<int64_t>& offsets,
+               const std::vector<int>&     lengths,
+               const unsigned char*        data,
+               const FileHints&            hints = FileHints()) const {
+        Utils::runtime_assert(offsets.size() == lengths.size(), "Piece count mismatch.");
+
+        const size_t quota  = std::max(size_t(1), m_round_bytes / size_t(m_group.size()));
+        auto         rounds = split_rounds(offsets, lengths, quota);
+
+        unsigned long n_rounds = std::max(size_t(1), rounds.size());
+        Mpi::allreduce(MPI_IN_PLACE, &n_rounds, 1, MPI_UNSIGNED_LONG, MPI_MAX, m_comm.get_handle());
+        rounds.resize(n_rounds);
+
+        std::optional<File> file;
+        if (m_is_aggregator) { file.emplace(File::create(m_aggregators, path, hints)); }
+        for (const auto& round : rounds) { write_round(file, round, data); }
+        if (file) { file->close(); }
+
+        // the file is closed by the aggregator before the group returns
+        Mpi::barrier(m_group.get_handle());
+    }
+
+    ///
+    ///@brief Writes the interior of a distributed array as one global C-order array at offset
+    /// disp of a file, the same layout as write_array(). Collective over the communicator of the
+    /// aggregator, which has to contain the same processes as the communicator of arr. The data
+    /// is written in rounds of at most round_bytes() per aggregator, see write().
+    ///
+    ///@param path the file name
+    ///@param arr the array
+    ///@param disp offset of the array in bytes, default = 0
+    ///@param hints tuning hints of the file, default = none
+    ///
+    template <class T, size_t N>
+    void write_array(const std::string&            path,
+                     const DistributedArray<T, N>& arr,
+                     MPI_Offset                    disp  = 0,
+                     const FileHints&              hints = FileHints()) const {
+
+        const auto global = arr.global_extents();
+        const auto local  = arr.local_extents();
+        const auto start  = arr.local_offsets();
+
+        // one piece per row along the last (contiguous) direction
+        const size_t         row  = local[N - 1];
+        const size_t         rows = row == 0 ? 0 : arr.local_size() / row;
+        std::vector<int64_t> offsets(rows);
+        std::vector<int>     lengths(rows, int(row * sizeof(T)));
+        for (size_t r = 0; r < rows; ++r) {
+            size_t rest = r, linear = 0, stride = global[N - 1];
+            for (size_t d = N - 1; d-- > 0;) {
+                linear += (start[d] + rest % local[d]) * stride;
+                rest /= local[d];
+                stride *= global[d];
+            }
+            linear += start[N - 1];
+            offsets[r] = int64_t(disp) + int64_t(linear * sizeof(T));
+        }
+
+        std::vector<T> interior(arr.local_size());
+        arr.copy_interior(interior.data());
+        auto bytes = reinterpret_cast<const unsigned char*>(interior.data());
+        write(path, offsets, lengths, bytes, hints);
+    }
+
+    ///
+    ///@brief Sets the maximum number of bytes an aggregator gathers and writes at a time, e.g. to
+    /// bound the memory of the aggregators
+    ///
+    ///@param bytes the limit, at most INT_MAX, default = INT_MAX
+    ///
+    void set_round_bytes(size_t bytes) {
+        Utils::runtime_assert(bytes > 0 && bytes <= size_t(INT_MAX), "Invalid round size.");
+        m_round_bytes = std::clamp(bytes, size_t(1), size_t(INT_MAX));
+    }
+
+    ///
+    ///@brief Get the maximum number of bytes an aggregator gathers and writes at a time
+    ///
+    ///@return size_t the limit
+    ///
+    size_t round_bytes() const { return m_round_bytes; }
+
+    ///
+    ///@brief Checks if this process writes to the file
+    ///
+    ///@return true if this process is an aggregator
+    ///
+    bool is_aggregator() const { return m_is_aggregator; }
+
+    ///
+    ///@brief Get the total number of aggregators
+    ///
+    ///@return int number of writing processes
+    ///
+    int n_aggregators() const { return m_n_aggregators; }
+
+    ///
+    ///@brief Get the communicator of the processes sharing the aggregator of this process, the
+    /// aggregator is rank 0
+    ///
+    ///@return const Communicator& the group communicator
+    ///
+    const Communicator& get_group() const { return m_group; }
+
+    ///
+    ///@brief Get the communicator
+    ///
+    ///@return const Communicator& the communicator
+    ///
+    const Communicator& get_communicator() const { return m_comm; }
+
+private:
+    Communicator m_comm;
+    Communicator m_group;
+    Communicator m_aggregators; // MPI_COMM_NULL on the other processes
+    bool         m_is_aggregator = false;
+    int          m_n_aggregators = 0;
+    size_t       m_round_bytes   = size_t(INT_MAX);
+
+    // the pieces of one round, stored one after another from data + begin
+    struct Round {
+        std::vector<int64_t> offsets;
+        std::vector<int>     lengths;
+        size_t               begin = 0;
+        size_t               bytes = 0;
+    };
+
+    static std::vector<int> exclusive_sum(const std::vector<int>& counts) {
+        std::vector<int> ret(counts.size(), 0);
+        for (size_t i = 1; i < counts.size(); ++i) { ret[i] = ret[i - 1] + counts[i - 1]; }
+        return ret;
+    }
+
+    ///
+    ///@brief Splits the pieces into rounds of at most quota bytes, empty pieces are dropped
+    ///
+    static std::vector<Round> split_rounds(const std::vector<int64_t>& offsets,
+                                           const std::vector<int>&     lengths,
+                                           size_t                      quota) {
+        std::vector<Round> rounds;
+        size_t             pos = 0;
+        for (size_t i = 0; i < offsets.size(); ++i) {
+            Utils::runtime_assert(lengths[i] >= 0, "Negative piece length.");
+            int64_t offset = offsets[i];
+            size_t  length = size_t(std::max(lengths[i], 0));
+            while (length > 0) {
+                if (rounds.empty() || rounds.back().bytes == quota) {
+                    rounds.emplace_back();
+                    rounds.back().begin = pos;
+                }
+                auto&        r    = rounds.back();
+                const size_t take = std::min(length, quota - r.bytes);
+                r.offsets.push_back(offset);
+                r.lengths.push_back(int(take));
+                r.bytes += take;
+                offset += int64_t(take);
+                length -= take;
+                pos += take;
+            }
+        }
+        return rounds;
+    }
+
+    ///
+    ///@brief Gathers one round of every process of the group to the aggregator and writes it.
+    /// Collective over the communicator, the group has at most m_round_bytes bytes.
+    ///
+    void
+    write_round(std::optional<File>& file, const Round& round, const unsigned char* data) const {
+        int counts[2] = {int(round.offsets.size()), int(round.bytes)};
+
+        const MPI_Comm group      = m_group.get_handle();
+        const int      group_size = m_group.size();
+
+        std::vector<int> all_counts(m_is_aggregator ? 2 * size_t(group_size) : 0);
+        Mpi::gather(counts, 2, MPI_INT, all_counts.data(), 2, MPI_INT, 0, group);
+
+        std::vector<int> piece_counts, piece_displs, byte_counts, byte_displs;
+        if (m_is_aggregator) {
+            for (int r = 0; r < group_size; ++r) {
+                piece_counts.push_back(all_counts[2 * size_t(r)]);
+                byte_counts.push_back(all_counts[2 * size_t(r) + 1]);
+            }
+            piece_displs = exclusive_sum(piece_counts);
+            byte_displs  = exclusive_sum(byte_counts);
+        }
+        const size_t n_pieces =
+            m_is_aggregator ? size_t(piece_displs.back() + piece_counts.back()) : 0;
+        const size_t n_total =
+            m_is_aggregator ? size_t(byte_displs.back() + byte_counts.back()) : 0;
+
+        std::vector<int64_t>      all_offsets(n_pieces);
+        std::vector<int>          all_lengths(n_pieces);
+        PoolVector<unsigned char> all_data(n_total);
+        Mpi::gatherv(round.offsets.data(),
+                     counts[0],
+                     MPI_INT64_T,
+                     all_offsets.data(),
+                     piece_counts.data(),
+                     piece_displs.data(),
+                     MPI_INT64_T,
+                     0,
+                     group);
+        Mpi::gatherv(round.lengths.data(),
+                     counts[0],
+                     MPI_INT,
+                     all_lengths.data(),
+                     piece_counts.data(),
+                     piece_displs.data(),
+                     MPI_INT,
+                     0,
+                     group);
+        Mpi::gatherv(data + round.begin,
+                     counts[1],
+                     MPI_BYTE,
+                     all_data.data(),
+                     byte_counts.data(),
+                     byte_displs.data(),
+                     MPI_BYTE,
+                     0,
+                     group);
+
+        if (file) { write_sorted(*file, all_offsets, all_lengths, all_data); }
+    }
+
+    ///
+    ///@brief Sorts the gathered pieces by offset, merges adjacent ones and writes them with one
+    /// collective write of the aggregators
+    ///
+    static void write_sorted(File&                            file,
+                             const std::vector<int64_t>&      offsets,
+                             const std::vector<int>&          lengths,
+                             const PoolVector<unsigned char>& data) {
+
+        std::vector<size_t> starts(offsets.size(), 0);
+        for (size_t i = 1; i < offsets.size(); ++i) {
+            starts[i] = starts[i - 1] + size_t(lengths[i - 1]);
+        }
+        std::vector<size_t> order(offsets.size());
+        std::iota(order.begin(), order.end(), size_t(0));
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return offsets[a] < offsets[b];
+        });
+
+        PoolVector<unsigned char> sorted(data.size());
+        std::vector<MPI_Aint>     displs;
+        std::vector<int>          blocks;
+        size_t                    pos = 0;
+        for (auto i : order) {
+            std::copy_n(data.begin() + std::ptrdiff_t(starts[i]),
+                        lengths[i],
+                        sorted.begin() + std::ptrdiff_t(pos));
+            pos += size_t(lengths[i]);
+            if (!displs.empty() && displs.back() + blocks.back() == MPI_Aint(offsets[i])) {
+                blocks.back() += lengths[i];
+            } else {
+                displs.push_back(MPI_Aint(offsets[i]));
+                blocks.push_back(lengths[i]);
+            }
+        }
+
+        if (displs.empty()) {
+            file.set_view(0, MpiDatatype<unsigned char>(), MpiDatatype<unsigned char>());
+        } else {
+            auto filetype = DerivedDatatype::hindexed(blocks, displs, MpiDatatype<unsigned char>());
+            file.set_view(0, MpiDatatype<unsigned char>(), filetype);
+        }
+        file.write_all(sorted.data(), int(pos), MpiDatatype<unsigned char>());
+    }
+};
+
+} // namespace MpiWrapper
@@ -0,0 +1,401 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "mpi_buffer_pool.hpp"
+#include "mpi_cart_communicator.hpp"
+#include "mpi_native_datatypes.hpp"
+#include "mpi_request.hpp"
+#include "runtime_assert.hpp"
+
+namespace MpiWrapper {
+
+///
+///@brief Moves particles which have left the local subdomain of a Cartesian decomposition to the
+/// owning neighbour, including the diagonal neighbours. The particles are stored as structure of
+/// arrays, i.e. one vector per position component and one vector per additional field.
+///
+/// A migration is a single pass classifying the particles into the 3^N - 1 neighbour directions,
+/// a packing pass into one contiguous buffer per direction (the components stay separated within
+/// each direction so that unpacking is a plain copy), the exchange of the counts and the
+/// particles with the precomputed neighbours and an in-place compaction of the staying particles
+/// which overlaps the data exchange. The particles may move at most one subdomain per migration.
+/// Particles leaving through a periodic boundary are wrapped, particles leaving through a
+/// non-periodic boundary are removed.
+///
+///@tparam N number of dimensions
+///
+template <size_t N> class ParticleMigrator {
+
+    static constexpr size_t pow3(size_t n) { return n == 0 ? 1 : 3 * pow3(n - 1); }
+
+public:
+    ///
+    ///@brief Number of directions including the centre
+    ///
+    static constexpr size_t n_directions = pow3(N);
+
+    ///
+    ///@brief Direction index of the particles staying on this process
+    ///
+    static constexpr size_t centre = (n_directions - 1) / 2;
+
+    ///
+    ///@brief Construct a new Particle Migrator, the global box is split uniformly over the
+    /// processes of the topology
+    ///
+    ///@param comm the Cartesian communicator
+    ///@param global_lo lower corner of the global domain
+    ///@param global_hi upper corner of the global domain
+    ///@param tag message tag of the exchanges, default = 1
+    ///
+    ParticleMigrator(const CartCommunicator<N>&   comm,
+                     const std::array<double, N>& global_lo,
+                     const std::array<double, N>& global_hi,
+                     int                          tag = 1)
+        : ParticleMigrator(comm,
+                           global_lo,
+                           global_hi,
+                           uniform_lo(comm, global_lo, global_hi),
+                           uniform_hi(comm, global_lo, global_hi),
+                           tag) {}
+
+    ///
+    ///@brief Construct a new Particle Migrator with a given local subdomain, e.g. after load
+    /// balancing. The subdomains have to form a tensor-product partition of the global box.
+    ///
+    ///@param comm the Cartesian communicator
+    ///@param global_lo lower corner of the global domain
+    ///@param global_hi upper corner of the global domain
+    ///@param local_lo lower corner of the subdomain of this process
+    ///@param local_hi upper corner of the subdomain of this process
+    ///@param tag message tag of the exchanges, default = 1
+    ///
+    ParticleMigrator(const CartCommunicator<N>&   comm,
+                     const std::array<double, N>& global_lo,
+                     const std::array<double, N>& global_hi,
+                     const std::array<double, N>& local_lo,
+                     const std::array<double, N>& local_hi,
+                     int                          tag = 1)
+        : m_comm(comm)
+        , m_tag(tag)
+        , m_local_lo(local_lo)
+        , m_local_hi(local_hi) {
+
+        auto periods = m_comm.get_periods();
+        for (size_t d = 0; d < N; ++d) {
+            Utils::runtime_assert(global_lo[d] < global_hi[d], "Invalid global domain.");
+            Utils::runtime_assert(local_lo[d] <= local_hi[d], "Invalid local domain.");
+            m_length[d]   = global_hi[d] - global_lo[d];
+            m_periodic[d] = periods[d] != 0;
+            m_at_lo[d]    = local_lo[d] <= global_lo[d];
+            m_at_hi[d]    = local_hi[d] >= global_hi[d];
+        }
+
+        for (size_t k = 0; k < n_directions; ++k) {
+            auto [source, dest] = m_comm.shift(direction(k));
+            m_send_ranks[k]     = source; // the neighbour at coords + direction
+            m_recv_ranks[k]     = dest;   // receives the particles moving along direction
+        }
+        m_send_ranks[centre] = MPI_PROC_NULL;
+        m_recv_ranks[centre] = MPI_PROC_NULL;
+    }
+
+    ///
+    ///@brief Get the offset of direction k, each component is -1, 0 or 1. Direction 0 has
+    /// the slowest index.
+    ///
+    ///@param k direction index
+    ///@return std::array<int, N> the offset
+    ///
+    static constexpr std::array<int, N> direction(size_t k) {
+        std::array<int, N> ret{};
+        for (size_t d = N; d-- > 0;) {
+            ret[d] = int(k % 3) - 1;
+            k /= 3;
+        }
+        return ret;
+    }
+
+    ///
+    ///@brief Get the neighbour rank of a direction
+    ///
+    ///@param k direction index
+    ///@return int rank of the neighbour at coords + direction(k) or MPI_PROC_NULL
+    ///
+    int neighbour(size_t k) const { return m_send_ranks[k]; }
+
+    ///
+    ///@brief Classifies the particles into the neighbour directions. The loops run over one
+    /// component at a time without branches so that they vectorize.
+    ///
+    ///@param x the position components
+    ///@return const std::vector<uint8_t>& direction index of each particle
+    ///
+    const std::vector<uint8_t>& classify(const std::array<std::vector<double>, N>& x) {
+        static_assert(n_directions <= 256, "Too many directions for uint8_t.");
+
+        const size_t n = x[0].size();
+        m_direction.assign(n, uint8_t(0));
+        uint8_t* dir = m_direction.data();
+
+        uint8_t stride = 1;
+        for (size_t d = N; d-- > 0;) {
+            Utils::runtime_assert(x[d].size() == n, "Position components of different sizes.");
+            const double* xd = x[d].data();
+            const double  lo = m_local_lo[d];
+            const double  hi = m_local_hi[d];
+            for (size_t i = 0; i < n; ++i) {
+                auto code = uint8_t(1 + int(xd[i] >= hi) - int(xd[i] < lo));
+                dir[i]    = uint8_t(dir[i] + code * stride);
+            }
+            stride = uint8_t(stride * 3);
+        }
+        return m_direction;
+    }
+
+    ///
+    ///@brief Migrates the particles, collective over the communicator. On return x and all the
+    /// fields contain the particles owned by this process: the staying particles in their
+    /// original order followed by the received ones.
+    ///
+    ///@param x the position components
+    ///@param fields additional per-particle fields, trivially copyable element types
+    ///@return size_t number of particles sent away (including the removed ones)
+    ///
+    template <class... Fields>
+    size_t migrate(std::array<std::vector<double>, N>& x, std::vector<Fields>&... fields) {
+
+        static_assert((std::is_trivially_copyable_v<Fields> && ...),
+                      "Particle fields have to be trivially copyable.");
+
+        const size_t n = x[0].size();
+        Utils::runtime_assert(((fields.size() == n) && ...), "Fields of different sizes.");
+
+        classify(x);
+
+        // particle counts and buffer offsets per direction
+        std::array<size_t, n_directions> send_counts{};
+        for (size_t i = 0; i < n; ++i) { ++send_counts[m_direction[i]]; }
+        const size_t n_leaving = n - send_counts[centre];
+        send_counts[centre]    = 0;
+
+        std::array<size_t, n_directions> recv_counts{};
+        {
+            std::vector<Request> requests;
+            requests.reserve(2 * n_directions);
+            for (size_t k = 0; k < n_directions; ++k) {
+                if (k == centre) { continue; }
+                requests.push_back(m_comm.irecv(
+                    &recv_counts[k], 1, MpiDatatype<size_t>(), m_recv_ranks[k], m_tag));
+                requests.push_back(m_comm.isend(
+                    &send_counts[k], 1, MpiDatatype<size_t>(), m_send_ranks[k], m_tag));
+            }
+            for (auto& request : requests) { request.wait(); }
+        }
+
+        constexpr size_t particle_bytes = N * sizeof(double) + (sizeof(Fields) + ... + 0);
+
+        std::array<size_t, n_directions + 1> send_offsets{};
+        std::array<size_t, n_directions + 1> recv_offsets{};
+        for (size_t k = 0; k < n_directions; ++k) {
+            send_offsets[k + 1] = send_offsets[k] + send_counts[k];
+            recv_offsets[k + 1] = recv_offsets[k] + recv_counts[k];
+        }
+        m_send_buffer.resize(send_offsets.back() * particle_bytes);
+        m_recv_buffer.resize(recv_offsets.back() * particle_bytes);
+
+        // slot of each leaving particle within its direction
+        m_slot.resize(n);
+        {
+            std::array<size_t, n_directions> fill{};
+            for (size_t i = 0; i < n; ++i) { m_slot[i] = fill[m_direction[i]]++; }
+        }
+
+        // component by component, direction k holds [x0...][x1...]...[fields...]
+        size_t component_offset = 0;
+        for (size_t d = 0; d < N; ++d) {
+            pack(x[d], send_counts, send_offsets, particle_bytes, component_offset);
+            wrap(d, send_counts, send_offsets, particle_bytes, component_offset);
+            component_offset += sizeof(double);
+        }
+        ((pack(fields, send_counts, send_offsets, particle_bytes, component_offset),
+          component_offset += sizeof(Fields)),
+         ...);
+
+        std::vector<Request> requests;
+        requests.reserve(2 * n_directions);
+        for (size_t k = 0; k < n_directions; ++k) {
+            if (recv_counts[k] > 0) {
+                requests.push_back(
+                    m_comm.irecv(m_recv_buffer.data() + recv_offsets[k] * particle_bytes,
+                                 int(recv_counts[k] * particle_bytes),
+                                 MpiDatatype<unsigned char>(),
+                                 m_recv_ranks[k],
+                                 m_tag));
+            }
+            if (send_counts[k] > 0) {
+                requests.push_back(
+                    m_comm.isend(m_send_buffer.data() + send_offsets[k] * particle_bytes,
+                                 int(send_counts[k] * particle_bytes),
+                                 MpiDatatype<unsigned char>(),
+                                 m_send_ranks[k],
+                                 m_tag));
+            }
+        }
+
+        // the staying particles are compacted while the messages are in flight
+        for (size_t d = 0; d < N; ++d) { compact(x[d]); }
+        (compact(fields), ...);
+
+        for (auto& request : requests) { request.wait(); }
+
+        component_offset = 0;
+        for (size_t d = 0; d < N; ++d) {
+            unpack(x[d], recv_counts, recv_offsets, particle_bytes, component_offset);
+            component_offset += sizeof(double);
+        }
+        ((unpack(fields, recv_counts, recv_offsets, particle_bytes, component_offset),
+          component_offset += sizeof(Fields)),
+         ...);
+
+        return n_leaving;
+    }
+
+private:
+    CartCommunicator<N>           m_comm;
+    int                           m_tag;
+    std::array<double, N>         m_local_lo;
+    std::array<double, N>         m_local_hi;
+    std::array<double, N>         m_length{};
+    std::array<bool, N>           m_periodic{};
+    std::array<bool, N>           m_at_lo{};
+    std::array<bool, N>           m_at_hi{};
+    std::array<int, n_directions> m_send_ranks{};
+    std::array<int, n_directions> m_recv_ranks{};
+
+    // work buffers reused between the migrations
+    std::vector<uint8_t>       m_direction;
+    std::vector<size_t>        m_slot;
+    PoolVector<unsigned char> m_send_buffer;
+    PoolVector<unsigned char> m_recv_buffer;
+
+    static std::array<double, N> uniform_lo(const CartCommunicator<N>&   comm,
+                                            const std::array<double, N>& lo,
+                                            const std::array<double, N>& hi) {
+        auto                  dims   = comm.get_topology_dims();
+        auto                  coords = comm.get_coords();
+        std::array<double, N> ret;
+        for (size_t d = 0; d < N; ++d) {
+            ret[d] = lo[d] + (hi[d] - lo[d]) * double(coords[d]) / double(dims[d]);
+        }
+        return ret;
+    }
+
+    static std::array<double, N> uniform_hi(const CartCommunicator<N>&   comm,
+                                            const std::array<double, N>& lo,
+                                            const std::array<double, N>& hi) {
+        auto                  dims   = comm.get_topology_dims();
+        auto                  coords = comm.get_coords();
+        std::array<double, N> ret;
+        for (size_t d = 0; d < N; ++d) {
+            ret[d] = coords[d] + 1 == dims[d]
+                         ? hi[d]
+                         : lo[d] + (hi[d] - lo[d]) * double(coords[d] + 1) / double(dims[d]);
+        }
+        return ret;
+    }
+
+    ///
+    ///@brief Start of the component at component_offset of direction k in a packed buffer
+    ///
+    template <class Buffer>
+    static auto segment(Buffer&                                     buffer,
+                        const std::array<size_t, n_directions>&     counts,
+                        const std::array<size_t, n_directions + 1>& offsets,
+                        size_t                                      particle_bytes,
+                        size_t                                      component_offset,
+                        size_t                                      k) {
+        return buffer.data() + offsets[k] * particle_bytes + counts[k] * component_offset;
+    }
+
+    ///
+    ///@brief Copies one component of the leaving particles into the send buffer
+    ///
+    template <class T>
+    void pack(const std::vector<T>&                       v,
+              const std::array<size_t, n_directions>&     counts,
+              const std::array<size_t, n_directions + 1>& offsets,
+              size_t                                      particle_bytes,
+              size_t                                      component_offset) {
+        for (size_t i = 0; i < v.size(); ++i) {
+            const size_t k = m_direction[i];
+            if (k == centre) { continue; }
+            auto* base = segment(m_send_buffer, counts, offsets, particle_bytes, component_offset, k);
+            std::memcpy(base + m_slot[i] * sizeof(T), &v[i], sizeof(T));
+        }
+    }
+
+    ///
+    ///@brief Shifts the packed position component d of the particles leaving through a periodic
+    /// boundary by the length of the global domain
+    ///
+    void wrap(size_t                                      d,
+              const std::array<size_t, n_directions>&     counts,
+              const std::array<size_t, n_directions + 1>& offsets,
+              size_t                                      particle_bytes,
+              size_t                                      component_offset) {
+        if (!m_periodic[d]) { return; }
+        for (size_t k = 0; k < n_directions; ++k) {
+            const int step = direction(k)[d];
+            double    shift = 0.0;
+            if (step < 0 && m_at_lo[d]) { shift = m_length[d]; }
+            if (step > 0 && m_at_hi[d]) { shift = -m_length[d]; }
+            if (shift == 0.0 || counts[k] == 0) { continue; }
+
+            auto* base = segment(m_send_buffer, counts, offsets, particle_bytes, component_offset, k);
+            for (size_t s = 0; s < counts[k]; ++s) {
+                double value;
+                std::memcpy(&value, base + s * sizeof(double), sizeof(double));
+                value += shift;
+                std::memcpy(base + s * sizeof(double), &value, sizeof(double));
+            }
+        }
+    }
+
+    ///
+    ///@brief Moves the staying particles to the front keeping their order, the vector only shrinks
+    /// so its storage is not reallocated
+    ///
+    template <class T> void compact(std::vector<T>& v) const {
+        size_t j = 0;
+        for (size_t i = 0; i < v.size(); ++i) {
+            if (m_direction[i] == centre) { v[j++] = v[i]; }
+        }
+        v.resize(j);
+    }
+
+    ///
+    ///@brief Appends one component of the received particles
+    ///
+    template <class T>
+    void unpack(std::vector<T>&                             v,
+                const std::array<size_t, n_directions>&     counts,
+                const std::array<size_t, n_directions + 1>& offsets,
+                size_t                                      particle_bytes,
+                size_t                                      component_offset) const {
+        const size_t begin = v.size();
+        v.resize(begin + offsets.back());
+        for (size_t k = 0; k < n_directions; ++k) {
+            if (counts[k] == 0) { continue; }
+            auto* base = segment(m_recv_buffer, counts, offsets, particle_bytes, component_offset, k);
+            std::memcpy(v.data() + begin + offsets[k], base, counts[k] * sizeof(T));
+        }
+    }
+};
+
+} // namespace MpiWrapper
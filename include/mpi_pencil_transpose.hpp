@@ -0,0 +1,227 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "block_partition.hpp"
+#include "mpi_cart_communicator.hpp"
+#include "mpi_derived_datatype.hpp"
+#include "mpi_functions.hpp"
+#include "mpi_native_datatypes.hpp"
+#include "runtime_assert.hpp"
+
+namespace MpiWrapper {
+
+///
+///@brief The direction which is not split between the processes
+///
+enum class Pencil { X = 0, Y = 1, Z = 2 };
+
+///
+///@brief Redistributes a 3D global array between x-, y- and z-pencil decompositions on a 2D
+/// process grid, the building block of distributed 3D FFTs. With the grid dims [P0, P1] the
+/// pencils are split as
+///
+///     x-pencil: x full,         y split by P0, z split by P1
+///     y-pencil: x split by P0,  y full,        z split by P1
+///     z-pencil: x split by P0,  y split by P1, z full
+///
+/// so that x <-> y transposes only involve the P0 processes of a grid row and y <-> z transposes
+/// the P1 processes of a grid column. All local blocks are stored with x as the fastest running
+/// index, i.e. element (i, j, k) is at i + nx * (j + ny * k). The subarray datatypes of every
+/// peer are created once on construction and each transpose is a single MPI_Alltoallw on the
+/// sub-communicator which packs and unpacks directly from the user buffers.
+///
+///@tparam T element type, requires an MpiDatatype<T> specialization
+///
+template <class T> class PencilTranspose {
+public:
+    ///
+    ///@brief Construct a new Pencil Transpose object, collective over the grid
+    ///
+    ///@param grid the 2D process grid
+    ///@param global_extents global number of points in x, y and z
+    ///
+    PencilTranspose(const CartCommunicator<2>& grid, const std::array<size_t, 3>& global_extents)
+        : m_row(grid.sub<1>({1, 0}))
+        , m_col(grid.sub<1>({0, 1}))
+        , m_global(global_extents) {
+
+        auto dims   = grid.get_topology_dims();
+        auto coords = grid.get_coords();
+
+        // the grid dimension which splits each direction of each pencil, full directions are -1
+        constexpr int split[3][3] = {{-1, 0, 1}, {0, -1, 1}, {0, 1, -1}};
+
+        for (size_t p = 0; p < 3; ++p) {
+            for (size_t d = 0; d < 3; ++d) {
+                if (split[p][d] < 0) {
+                    m_extents[p][d] = m_global[d];
+                    m_offsets[p][d] = 0;
+                } else {
+                    auto g          = size_t(split[p][d]);
+                    m_extents[p][d] = Utils::block_size(m_global[d], dims[g], coords[g]);
+                    m_offsets[p][d] = Utils::block_offset(m_global[d], dims[g], coords[g]);
+                }
+            }
+        }
+
+        m_xy = make_exchange(Pencil::X, Pencil::Y, dims[0]);
+        m_yz = make_exchange(Pencil::Y, Pencil::Z, dims[1]);
+    }
+
+    ///
+    ///@brief Get the local block extents of the given pencil
+    ///
+    ///@param p the pencil
+    ///@return std::array<size_t, 3> number of local points in x, y and z
+    ///
+    std::array<size_t, 3> local_extents(Pencil p) const { return m_extents[size_t(p)]; }
+
+    ///
+    ///@brief Get the global index of the first local point of the given pencil
+    ///
+    ///@param p the pencil
+    ///@return std::array<size_t, 3> global x, y and z index of the local block origin
+    ///
+    std::array<size_t, 3> local_offsets(Pencil p) const { return m_offsets[size_t(p)]; }
+
+    ///
+    ///@brief Get the number of local elements of the given pencil
+    ///
+    ///@param p the pencil
+    ///@return size_t the buffer size required for the pencil
+    ///
+    size_t local_size(Pencil p) const {
+        auto e = local_extents(p);
+        return e[0] * e[1] * e[2];
+    }
+
+    ///
+    ///@brief Get the global extents
+    ///
+    ///@return std::array<size_t, 3> global number of points in x, y and z
+    ///
+    std::array<size_t, 3> global_extents() const { return m_global; }
+
+    ///
+    ///@brief Transposes from x-pencils to y-pencils, collective over the grid row
+    ///
+    ///@param in x-pencil data, local_size(Pencil::X) elements
+    ///@param out y-pencil data, local_size(Pencil::Y) elements, may not alias in
+    ///
+    void x_to_y(const T* in, T* out) const { run(m_xy, false, m_row, in, out); }
+
+    ///
+    ///@brief Transposes from y-pencils to x-pencils, collective over the grid row
+    ///
+    ///@param in y-pencil data, local_size(Pencil::Y) elements
+    ///@param out x-pencil data, local_size(Pencil::X) elements, may not alias in
+    ///
+    void y_to_x(const T* in, T* out) const { run(m_xy, true, m_row, in, out); }
+
+    ///
+    ///@brief Transposes from y-pencils to z-pencils, collective over the grid column
+    ///
+    ///@param in y-pencil data, local_size(Pencil::Y) elements
+    ///@param out z-pencil data, local_size(Pencil::Z) elements, may not alias in
+    ///
+    void y_to_z(const T* in, T* out) const { run(m_yz, false, m_col, in, out); }
+
+    ///
+    ///@brief Transposes from z-pencils to y-pencils, collective over the grid column
+    ///
+    ///@param in z-pencil data, local_size(Pencil::Z) elements
+    ///@param out y-pencil data, local_size(Pencil::Y) elements, may not alias in
+    ///
+    void z_to_y(const T* in, T* out) const { run(m_yz, true, m_col, in, out); }
+
+private:
+    ///
+    ///@brief Precomputed alltoallw arguments of a transpose between pencils a and b. The a-side
+    /// arrays describe the blocks in the a-layout and the b-side arrays in the b-layout, the
+    /// reverse transpose just swaps the sides.
+    ///
+    struct Exchange {
+        std::vector<DerivedDatatype> a_types, b_types;
+        std::vector<MPI_Datatype>    a_handles, b_handles;
+        std::vector<int>             a_counts, b_counts;
+        std::vector<int>             displs;
+    };
+
+    CartCommunicator<1>                  m_row;
+    CartCommunicator<1>                  m_col;
+    std::array<size_t, 3>                m_global;
+    std::array<std::array<size_t, 3>, 3> m_extents{};
+    std::array<std::array<size_t, 3>, 3> m_offsets{};
+    Exchange                             m_xy;
+    Exchange                             m_yz;
+
+    ///
+    ///@brief Creates the subarray types of the transpose between pencils a and b on a
+    /// sub-communicator of n_procs processes. The direction full in a is split into n_procs
+    /// blocks in b and vice versa, the peer j owns block j (ranks of a Cartesian sub-grid equal
+    /// their coordinates).
+    ///
+    Exchange make_exchange(Pencil a, Pencil b, size_t n_procs) const {
+
+        Exchange ex;
+        ex.a_types.reserve(n_procs);
+        ex.b_types.reserve(n_procs);
+        ex.displs.assign(n_procs, 0);
+
+        auto add_block = [&](Pencil layout,
+                             size_t dir,
+                             size_t j,
+                             std::vector<DerivedDatatype>& types,
+                             std::vector<MPI_Datatype>&    handles,
+                             std::vector<int>&             counts) {
+            auto sizes    = m_extents[size_t(layout)];
+            auto subsizes = sizes;
+            std::array<size_t, 3> starts{};
+            subsizes[dir] = Utils::block_size(m_global[dir], n_procs, j);
+            starts[dir]   = Utils::block_offset(m_global[dir], n_procs, j);
+
+            if (subsizes[0] * subsizes[1] * subsizes[2] == 0) {
+                types.emplace_back();
+                handles.push_back(MpiDatatype<T>::get_handle());
+                counts.push_back(0);
+                return;
+            }
+            types.push_back(DerivedDatatype::subarray(
+                sizes, subsizes, starts, MpiDatatype<T>(), MPI_ORDER_FORTRAN));
+            handles.push_back(types.back().get_handle());
+            counts.push_back(1);
+        };
+
+        for (size_t j = 0; j < n_procs; ++j) {
+            add_block(a, size_t(a), j, ex.a_types, ex.a_handles, ex.a_counts);
+            add_block(b, size_t(b), j, ex.b_types, ex.b_handles, ex.b_counts);
+        }
+        return ex;
+    }
+
+    static void
+    run(const Exchange& ex, bool reverse, const Communicator& comm, const T* in, T* out) {
+
+        Utils::runtime_assert(static_cast<const void*>(in) != static_cast<const void*>(out),
+                              "Transpose can not be done in place.");
+
+        const auto& send_counts  = reverse ? ex.b_counts : ex.a_counts;
+        const auto& send_handles = reverse ? ex.b_handles : ex.a_handles;
+        const auto& recv_counts  = reverse ? ex.a_counts : ex.b_counts;
+        const auto& recv_handles = reverse ? ex.a_handles : ex.b_handles;
+
+        Mpi::alltoallw(in,
+                       send_counts.data(),
+                       ex.displs.data(),
+                       send_handles.data(),
+                       out,
+                       recv_counts.data(),
+                       ex.displs.data(),
+                       recv_handles.data(),
+                       comm.get_handle());
+    }
+};
+
+} // namespace MpiWrapper
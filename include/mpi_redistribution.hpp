@@ -0,0 +1,159 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include "mpi_derived_datatype.hpp"
+#include "mpi_distributed_array.hpp"
+#include "mpi_functions.hpp"
+#include "mpi_native_datatypes.hpp"
+#include "mpi_request.hpp"
+#include "runtime_assert.hpp"
+
+namespace MpiWrapper {
+
+///
+///@brief Plan for moving the data of a DistributedArray to another DistributedArray of the same
+/// global extents but with a different decomposition (topology dims, partition boundaries,
+/// reordering or ghost width). The boxes of every process are exchanged once on construction and
+/// only the non-empty intersections become messages, each described by a pair of subarray
+/// datatypes directly into the local storages. Executing the plan is a set of sparse
+/// nonblocking point-to-point messages, there is no global gather.
+///
+/// Both arrays have to be distributed over the same processes, the messages are sent on the
+/// communicator of the source array.
+///
+///@tparam T element type
+///@tparam N number of dimensions
+///
+template <class T, size_t N> class Redistribution {
+public:
+    ///
+    ///@brief Construct a new Redistribution plan, collective over the communicator of src
+    ///
+    ///@param src the source decomposition
+    ///@param dst the destination decomposition
+    ///@param tag message tag used by execute(), default = 1
+    ///
+    Redistribution(const DistributedArray<T, N>& src,
+                   const DistributedArray<T, N>& dst,
+                   int                           tag = 1)
+        : m_comm(src.get_communicator())
+        , m_tag(tag) {
+
+        Utils::runtime_assert(src.global_extents() == dst.global_extents(),
+                              "Redistribution between different global extents.");
+        Utils::runtime_assert(src.get_communicator().size() == dst.get_communicator().size(),
+                              "Redistribution between different process counts.");
+
+        // every process publishes its source and destination box
+        const size_t n_procs = size_t(m_comm.size());
+        Box mine[2] = {{src.local_offsets(), src.local_extents()},
+                       {dst.local_offsets(), dst.local_extents()}};
+        std::vector<Box> all(2 * n_procs);
+
+        const int count = int(4 * N); // two boxes of offset and extent
+        Mpi::allgather(mine,
+                       count,
+                       MpiDatatype<size_t>::get_handle(),
+                       all.data(),
+                       count,
+                       MpiDatatype<size_t>::get_handle(),
+                       m_comm.get_handle());
+
+        for (size_t r = 0; r < n_procs; ++r) {
+            const Box& r_src = all[2 * r];
+            const Box& r_dst = all[2 * r + 1];
+
+            Box send_box = intersect(mine[0], r_dst);
+            if (!send_box.empty()) {
+                m_sends.push_back({int(r), make_type(src, send_box)});
+            }
+
+            Box recv_box = intersect(r_src, mine[1]);
+            if (!recv_box.empty()) {
+                m_recvs.push_back({int(r), make_type(dst, recv_box)});
+            }
+        }
+    }
+
+    ///
+    ///@brief Moves the interior data of src to the interior of dst, collective over the
+    /// communicator of src. The ghosts of dst are not updated.
+    ///
+    ///@param src array with the source decomposition of the plan
+    ///@param dst array with the destination decomposition of the plan
+    ///
+    void execute(const DistributedArray<T, N>& src, DistributedArray<T, N>& dst) const {
+
+        std::vector<Request> requests;
+        requests.reserve(m_sends.size() + m_recvs.size());
+
+        for (const auto& m : m_recvs) {
+            requests.push_back(m_comm.irecv(dst.data(), 1, m.type, m.rank, m_tag));
+        }
+        for (const auto& m : m_sends) {
+            requests.push_back(m_comm.isend(src.data(), 1, m.type, m.rank, m_tag));
+        }
+        for (auto& request : requests) { request.wait(); }
+    }
+
+    ///
+    ///@brief Get the number of messages sent by this process
+    ///
+    ///@return size_t number of non-empty outgoing intersections
+    ///
+    size_t send_count() const { return m_sends.size(); }
+
+    ///
+    ///@brief Get the number of messages received by this process
+    ///
+    ///@return size_t number of non-empty incoming intersections
+    ///
+    size_t recv_count() const { return m_recvs.size(); }
+
+private:
+    struct Box {
+        std::array<size_t, N> offset;
+        std::array<size_t, N> extent;
+
+        bool empty() const {
+            return std::any_of(extent.begin(), extent.end(), [](size_t e) { return e == 0; });
+        }
+    };
+
+    struct Message {
+        int             rank;
+        DerivedDatatype type;
+    };
+
+    Communicator         m_comm;
+    int                  m_tag;
+    std::vector<Message> m_sends;
+    std::vector<Message> m_recvs;
+
+    static Box intersect(const Box& a, const Box& b) {
+        Box ret;
+        for (size_t d = 0; d < N; ++d) {
+            size_t lo     = std::max(a.offset[d], b.offset[d]);
+            size_t hi     = std::min(a.offset[d] + a.extent[d], b.offset[d] + b.extent[d]);
+            ret.offset[d] = lo;
+            ret.extent[d] = hi > lo ? hi - lo : 0;
+        }
+        return ret;
+    }
+
+    ///
+    ///@brief Creates the subarray type of the global box in the local storage of arr
+    ///
+    static DerivedDatatype make_type(const DistributedArray<T, N>& arr, const Box& box) {
+        auto starts = arr.storage_origin();
+        auto offset = arr.local_offsets();
+        for (size_t d = 0; d < N; ++d) { starts[d] += box.offset[d] - offset[d]; }
+        return DerivedDatatype::subarray(
+            arr.storage_extents(), box.extent, starts, MpiDatatype<T>());
+    }
+};
+
+} // namespace MpiWrapper
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <mpi.h>
+
+#include "mpi_functions.hpp"
+
+namespace MpiWrapper {
+
+///
+///@brief Owning wrapper around a nonblocking MPI_Request. The request is move-only and waits for
+/// completion on destruction so that the communication buffers can not be released while the
+/// operation is still in flight.
+///
+class Request {
+public:
+    Request()
+        : m_handle(MPI_REQUEST_NULL) {}
+
+    explicit Request(MPI_Request handle)
+        : m_handle(handle) {}
+
+    Request(const Request& other) = delete;
+    Request& operator=(const Request& other) = delete;
+
+    Request(Request&& other) noexcept
+        : m_handle(other.release()) {}
+
+    Request& operator=(Request&& other) {
+        if (this != &other) {
+            wait();
+            m_handle = other.release();
+        }
+        return *this;
+    }
+
+    ~Request() { wait(); }
+
+    ///
+    ///@brief Blocks until the request completes
+    ///
+    ///
+    void wait() {
+        if (is_active()) { Mpi::wait(m_handle); }
+    }
+
+    ///
+    ///@brief Tests for completion without blocking
+    ///
+    ///@return true if the request has completed (or was never active)
+    ///@return false if the request is still pending
+    ///
+    bool test() {
+        if (!is_active()) { return true; }
+        return Mpi::test(m_handle);
+    }
+
+    ///
+    ///@brief Checks if the request is still associated with a pending operation
+    ///
+    ///@return true if not MPI_REQUEST_NULL
+    ///
+    bool is_active() const { return m_handle != MPI_REQUEST_NULL; }
+
+    ///
+    ///@brief Get the mpi-handle
+    ///
+    ///@return MPI_Request handle
+    ///
+    MPI_Request get_handle() const { return m_handle; }
+
+    ///
+    ///@brief Gives up the ownership of the handle, the caller becomes responsible for completing
+    /// the request.
+    ///
+    ///@return MPI_Request the released handle
+    ///
+    MPI_Request release() noexcept {
+        MPI_Request ret = m_handle;
+        m_handle        = MPI_REQUEST_NULL;
+        return ret;
+    }
+
+private:
+    MPI_Request m_handle;
+};
+
+} // namespace MpiWrapper
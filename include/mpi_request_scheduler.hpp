@@ -0,0 +1,176 @@
+#pragma once
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#endif
+
+#include "mpi_functions.hpp"
+#include "mpi_request.hpp"
+
+namespace MpiWrapper {
+
+///
+///@brief Progress engine for wrapper-issued requests. Pending requests are kept in a single
+/// contiguous array so that one progress() call tests all of them with a single MPI_Testsome and
+/// runs the continuations of the completed ones. With C++20 the requests can be co_await:ed, the
+/// suspended coroutine is then resumed from progress().
+///
+class RequestScheduler {
+public:
+    using callback_type = std::function<void()>;
+
+    RequestScheduler() = default;
+
+    RequestScheduler(const RequestScheduler& other) = delete;
+    RequestScheduler& operator=(const RequestScheduler& other) = delete;
+
+    ///
+    ///@brief Blocks until every pending request has completed, the continuations are not run.
+    ///
+    ~RequestScheduler() {
+        if (!m_requests.empty()) {
+            Mpi::wait_all(static_cast<int>(m_requests.size()), m_requests.data());
+        }
+    }
+
+    ///
+    ///@brief Hands the request over to the scheduler
+    ///
+    ///@param request request to track
+    ///@param on_complete continuation to run from progress() once the request has completed
+    ///
+    void submit(Request&& request, callback_type on_complete) {
+        if (!request.is_active()) {
+            on_complete();
+            return;
+        }
+        m_requests.push_back(request.release());
+        m_callbacks.push_back(std::move(on_complete));
+    }
+
+    ///
+    ///@brief Tests all pending requests with one MPI_Testsome and runs the continuations of the
+    /// completed ones. Continuations are allowed to submit new requests.
+    ///
+    ///@return size_t number of requests completed by this call
+    ///
+    size_t progress() {
+
+        if (m_requests.empty()) { return 0; }
+
+        m_indices.resize(m_requests.size());
+        int outcount =
+            Mpi::test_some(static_cast<int>(m_requests.size()), m_requests.data(), m_indices.data());
+
+        if (outcount == MPI_UNDEFINED || outcount == 0) { return 0; }
+
+        // Move the continuations out before compacting so that they can safely submit.
+        std::vector<callback_type> ready;
+        ready.reserve(static_cast<size_t>(outcount));
+        for (int i = 0; i < outcount; ++i) {
+            auto idx = static_cast<size_t>(m_indices[static_cast<size_t>(i)]);
+            ready.push_back(std::move(m_callbacks[idx]));
+        }
+
+        size_t n = 0;
+        for (size_t i = 0; i < m_requests.size(); ++i) {
+            if (m_requests[i] != MPI_REQUEST_NULL) {
+                m_requests[n]  = m_requests[i];
+                m_callbacks[n] = std::move(m_callbacks[i]);
+                ++n;
+            }
+        }
+        m_requests.resize(n);
+        m_callbacks.resize(n);
+
+        for (auto& callback : ready) { callback(); }
+
+        return static_cast<size_t>(outcount);
+    }
+
+    ///
+    ///@brief Calls progress() until there are no pending requests left
+    ///
+    ///
+    void run() {
+        while (!m_requests.empty()) { progress(); }
+    }
+
+    ///
+    ///@brief Get the number of pending requests
+    ///
+    ///@return size_t number of requests not yet completed
+    ///
+    size_t pending() const { return m_requests.size(); }
+
+    ///
+    ///@brief Get the scheduler used by co_await of a plain Request on this thread
+    ///
+    ///@return RequestScheduler& the thread-local default scheduler
+    ///
+    static RequestScheduler& this_thread() {
+        thread_local RequestScheduler scheduler;
+        return scheduler;
+    }
+
+#if defined(__cpp_impl_coroutine)
+
+    ///
+    ///@brief Awaitable which suspends the awaiting coroutine until the request has completed
+    ///
+    ///
+    class Awaitable {
+    public:
+        Awaitable(RequestScheduler& scheduler, Request&& request)
+            : m_scheduler(scheduler)
+            , m_request(std::move(request)) {}
+
+        bool await_ready() { return m_request.test(); }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            m_scheduler.submit(std::move(m_request), [handle]() { handle.resume(); });
+        }
+
+        void await_resume() const noexcept {}
+
+    private:
+        RequestScheduler& m_scheduler;
+        Request           m_request;
+    };
+
+    ///
+    ///@brief Makes the request awaitable on this scheduler
+    ///
+    ///@param request request to await
+    ///@return Awaitable object to co_await on
+    ///
+    Awaitable async(Request&& request) { return Awaitable(*this, std::move(request)); }
+
+#endif
+
+private:
+    std::vector<MPI_Request>   m_requests;
+    std::vector<callback_type> m_callbacks;
+    std::vector<int>           m_indices;
+};
+
+#if defined(__cpp_impl_coroutine)
+
+///
+///@brief Allows co_await comm.irecv(...), the coroutine is resumed from
+/// RequestScheduler::this_thread().progress()
+///
+///@param request request to await
+///@return RequestScheduler::Awaitable
+///
+inline RequestScheduler::Awaitable operator co_await(Request&& request) {
+    return RequestScheduler::this_thread().async(std::move(request));
+}
+
+#endif
+
+} // namespace MpiWrapper
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <numeric>
+#include <vector>
+
+#include "mpi_communicator.hpp"
+#include "mpi_functions.hpp"
+#include "mpi_native_datatypes.hpp"
+#include "runtime_assert.hpp"
+
+namespace MpiWrapper {
+
+namespace detail {
+
+///
+///@brief Selects P - 1 splitters by regular sampling. Every process contributes P samples at
+/// regular positions of its sorted keys, the samples are allgathered and the splitters are taken
+/// at regular positions of the sorted samples.
+///
+template <class Key, class Compare>
+std::vector<Key>
+select_splitters(const Communicator& comm, const std::vector<Key>& sorted, Compare comp) {
+
+    const size_t n_procs = size_t(comm.size());
+    const size_t n       = sorted.size();
+
+    const int        n_samples = int(std::min(n, n_procs));
+    std::vector<Key> samples(n_procs);
+    for (size_t i = 0; i < size_t(n_samples); ++i) {
+        samples[i] = sorted[(2 * i + 1) * n / (2 * size_t(n_samples))];
+    }
+
+    std::vector<int> all_counts(n_procs);
+    std::vector<Key> all_samples(n_procs * n_procs);
+    Mpi::allgather(
+        &n_samples, 1, MPI_INT, all_counts.data(), 1, MPI_INT, comm.get_handle());
+    Mpi::allgather(samples.data(),
+                   int(n_procs),
+                   MpiDatatype<Key>::get_handle(),
+                   all_samples.data(),
+                   int(n_procs),
+                   MpiDatatype<Key>::get_handle(),
+                   comm.get_handle());
+
+    // drop the unused sample slots of the processes with less than P keys
+    size_t valid = 0;
+    for (size_t p = 0; p < n_procs; ++p) {
+        for (size_t i = 0; i < size_t(all_counts[p]); ++i) {
+            all_samples[valid++] = all_samples[p * n_procs + i];
+        }
+    }
+    all_samples.resize(valid);
+    std::sort(all_samples.begin(), all_samples.end(), comp);
+
+    std::vector<Key> splitters;
+    if (valid == 0) { return splitters; }
+    splitters.reserve(n_procs - 1);
+    for (size_t p = 1; p < n_procs; ++p) { splitters.push_back(all_samples[p * valid / n_procs]); }
+    return splitters;
+}
+
+///
+///@brief Merges the consecutive sorted runs [displs[p], displs[p + 1]) of v pairwise
+///
+template <class T, class Compare>
+void merge_runs(std::vector<T>& v, std::vector<size_t> displs, Compare comp) {
+    while (displs.size() > 2) {
+        std::vector<size_t> merged;
+        merged.reserve(displs.size() / 2 + 2);
+        size_t i = 0;
+        for (; i + 2 < displs.size(); i += 2) {
+            std::inplace_merge(v.begin() + long(displs[i]),
+                               v.begin() + long(displs[i + 1]),
+                               v.begin() + long(displs[i + 2]),
+                               comp);
+            merged.push_back(displs[i]);
+        }
+        if (i + 1 < displs.size()) { merged.push_back(displs[i]); }
+        if (merged.back() != displs.back()) { merged.push_back(displs.back()); }
+        displs = std::move(merged);
+    }
+}
+
+///
+///@brief Sends the sorted local data to the owners given by the splitters with one Alltoallv per
+/// array. Returns the displacements of the received runs.
+///
+template <class Key, class Compare, class... Values>
+std::vector<size_t> exchange_sorted(const Communicator&      comm,
+                                    const std::vector<Key>&  splitters,
+                                    Compare                  comp,
+                                    std::vector<Key>&        keys,
+                                    std::vector<Values>&... values) {
+
+    const size_t n_procs = size_t(comm.size());
+
+    // the local keys are sorted, so the parts are found by binary search
+    std::vector<int> send_counts(n_procs, 0), recv_counts(n_procs, 0);
+    std::vector<int> send_displs(n_procs + 1, 0), recv_displs(n_procs + 1, 0);
+    size_t           begin = 0;
+    for (size_t p = 0; p < n_procs; ++p) {
+        size_t end = p < splitters.size()
+                         ? size_t(std::upper_bound(keys.begin() + long(begin),
+                                                   keys.end(),
+                                                   splitters[p],
+                                                   comp) -
+                                  keys.begin())
+                         : keys.size();
+        Utils::runtime_assert(end <= size_t(INT_MAX), "Too many elements for MPI_Alltoallv.");
+        send_counts[p]     = int(end - begin);
+        send_displs[p + 1] = int(end);
+        begin              = end;
+    }
+
+    Mpi::alltoall(send_counts.data(),
+                  1,
+                  MPI_INT,
+                  recv_counts.data(),
+                  1,
+                  MPI_INT,
+                  comm.get_handle());
+
+    size_t total = 0;
+    for (size_t p = 0; p < n_procs; ++p) {
+        total += size_t(recv_counts[p]);
+        Utils::runtime_assert(total <= size_t(INT_MAX), "Too many elements for MPI_Alltoallv.");
+        recv_displs[p + 1] = int(total);
+    }
+
+    auto exchange = [&](auto& v) {
+        using T = typename std::decay_t<decltype(v)>::value_type;
+        std::decay_t<decltype(v)> received(total);
+        Mpi::alltoallv(v.data(),
+                       send_counts.data(),
+                       send_displs.data(),
+                       MpiDatatype<T>::get_handle(),
+                       received.data(),
+                       recv_counts.data(),
+                       recv_displs.data(),
+                       MpiDatatype<T>::get_handle(),
+                       comm.get_handle());
+        v = std::move(received);
+    };
+    exchange(keys);
+    (exchange(values), ...);
+
+    return std::vector<size_t>(recv_displs.begin(), recv_displs.end());
+}
+
+///
+///@brief Ratio of the largest local size to the mean local size
+///
+inline double size_imbalance(const Communicator& comm, size_t n) {
+    unsigned long local = n, max_n = 0, sum_n = 0;
+    Mpi::allreduce(&local, &max_n, 1, MPI_UNSIGNED_LONG, MPI_MAX, comm.get_handle());
+    Mpi::allreduce(&local, &sum_n, 1, MPI_UNSIGNED_LONG, MPI_SUM, comm.get_handle());
+    if (sum_n == 0) { return 1.0; }
+    return double(max_n) * double(comm.size()) / double(sum_n);
+}
+
+} // namespace detail
+
+///
+///@brief Sorts keys distributed over the processes of a communicator with a sample sort. The
+/// local keys are sorted, P regular samples per process are allgathered to select P - 1
+/// splitters, the sorted keys are split by binary search against the splitters and sent to
+/// their owners with one MPI_Alltoallv and the P received runs are merged. On return the local
+/// keys are sorted and every key of rank r precedes the keys of rank r + 1. Collective over the
+/// communicator.
+///
+///@tparam Key key type with an MpiDatatype
+///@tparam Compare strict weak ordering of the keys, default = std::less
+///@param comm the communicator
+///@param keys the local keys, replaced by the sorted keys of this process
+///@param comp the ordering
+///@return double load imbalance of the result, max local size / mean local size
+///
+template <class Key, class Compare = std::less<Key>>
+double sample_sort(const Communicator& comm, std::vector<Key>& keys, Compare comp = Compare()) {
+
+    std::sort(keys.begin(), keys.end(), comp);
+    if (comm.size() == 1) { return 1.0; }
+
+    auto splitters = detail::select_splitters(comm, keys, comp);
+    auto displs    = detail::exchange_sorted(comm, splitters, comp, keys);
+    detail::merge_runs(keys, std::move(displs), comp);
+
+    return detail::size_imbalance(comm, keys.size());
+}
+
+///
+///@brief Sorts key-value pairs distributed over the processes of a communicator with a sample
+/// sort, see sample_sort(comm, keys, comp). The values follow their keys, pairs with equal keys
+/// keep their relative order within each process.
+///
+///@tparam Key key type with an MpiDatatype
+///@tparam Value value type with an MpiDatatype
+///@tparam Compare strict weak ordering of the keys, default = std::less
+///@param comm the communicator
+///@param keys the local keys, replaced by the sorted keys of this process
+///@param values the local values, same size as keys
+///@param comp the ordering
+///@return double load imbalance of the result, max local size / mean local size
+///
+template <class Key, class Value, class Compare = std::less<Key>>
+double sample_sort(const Communicator& comm,
+                   std::vector<Key>&   keys,
+                   std::vector<Value>& values,
+                   Compare             comp = Compare()) {
+
+    Utils::runtime_assert(keys.size() == values.size(), "Keys and values of different sizes.");
+
+    // the sort and the merge work on a permutation which is then applied to both arrays
+    std::vector<size_t> order(keys.size());
+    auto                apply = [&order, &keys, &values]() {
+        std::vector<Key>   sorted_keys(keys.size());
+        std::vector<Value> sorted_values(values.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            sorted_keys[i]   = keys[order[i]];
+            sorted_values[i] = values[order[i]];
+        }
+        keys   = std::move(sorted_keys);
+        values = std::move(sorted_values);
+    };
+    auto by_key = [&keys, &comp](size_t a, size_t b) { return comp(keys[a], keys[b]); };
+
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort(order.begin(), order.end(), by_key);
+    apply();
+    if (comm.size() == 1) { return 1.0; }
+
+    auto splitters = detail::select_splitters(comm, keys, comp);
+    auto displs    = detail::exchange_sorted(comm, splitters, comp, keys, values);
+
+    order.resize(keys.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    detail::merge_runs(order, std::move(displs), by_key);
+    apply();
+
+    return detail::size_imbalance(comm, keys.size());
+}
+
+} // namespace MpiWrapper
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "mpi_communicator.hpp"
+#include "mpi_derived_datatype.hpp"
+#include "mpi_functions.hpp"
+#include "mpi_native_datatypes.hpp"
+
+namespace MpiWrapper {
+
+namespace detail {
+
+///
+///@brief Offset of this rank (sum of the totals of the ranks below, MPI_Exscan) and the global
+/// total (MPI_Allreduce)
+///
+template <class T> void scan_offset(const Communicator& comm, T local, T& offset, T& total) {
+    offset = T{};
+    Mpi::exscan(&local, &offset, 1, MpiDatatype<T>::get_handle(), MPI_SUM, comm.get_handle());
+    Mpi::allreduce(&local, &total, 1, MpiDatatype<T>::get_handle(), MPI_SUM, comm.get_handle());
+    if (comm.get_rank() == 0) { offset = T{}; }
+}
+
+///
+///@brief Summary of the data of a rank for the segmented scan: the sum after the last segment
+/// head and whether the rank contains a head
+///
+template <class T> struct SegmentCarry {
+    T   value;
+    int closed;
+};
+
+///
+///@brief Non-commutative reduction of SegmentCarry, a segment head on the right discards the
+/// sum on the left. MPI computes inout = in op inout with in from the lower ranks.
+///
+template <class T> void combine_segments(void* in, void* inout, int* len, MPI_Datatype*) {
+    auto* a = static_cast<const SegmentCarry<T>*>(in);
+    auto* b = static_cast<SegmentCarry<T>*>(inout);
+    for (int i = 0; i < *len; ++i) {
+        if (!b[i].closed) { b[i].value = a[i].value + b[i].value; }
+        b[i].closed = a[i].closed | b[i].closed;
+    }
+}
+
+///
+///@brief Adds the carry of the lower ranks to the elements before the first local segment head
+///
+template <class T>
+void segmented_fix_up(const Communicator& comm, const uint8_t* heads, T* out, size_t n, T tail) {
+
+    size_t first_head = 0;
+    while (first_head < n && !heads[first_head]) { ++first_head; }
+
+    static_assert(std::is_trivially_copyable_v<SegmentCarry<T>>, "Invalid segment value type.");
+    SegmentCarry<T> local{tail, first_head < n ? 1 : 0};
+    SegmentCarry<T> carry{T{}, 0};
+
+    auto type = DerivedDatatype::contiguous(int(sizeof(SegmentCarry<T>)),
+                                            MpiDatatype<unsigned char>());
+    auto op   = Mpi::op_create(&combine_segments<T>, false);
+    Mpi::exscan(&local, &carry, 1, type.get_handle(), op, comm.get_handle());
+    Mpi::op_free(op);
+    if (comm.get_rank() == 0) { carry = SegmentCarry<T>{T{}, 0}; }
+
+    for (size_t i = 0; i < first_head; ++i) { out[i] += carry.value; }
+}
+
+} // namespace detail
+
+///
+///@brief Distributed inclusive prefix sum of an array distributed over the processes in rank
+/// order, out[i] is the sum of all the elements up to and including element i over all the
+/// ranks. The local array is scanned, the local totals are combined with MPI_Exscan and the
+/// offset is added in a vectorizable fix-up pass. Collective over the communicator.
+///
+///@tparam T arithmetic type with an MpiDatatype
+///@param comm the communicator
+///@param in local input elements
+///@param out local output elements, may be the same as in
+///@param n number of local elements
+///@return T the global sum
+///
+template <class T> T inclusive_scan(const Communicator& comm, const T* in, T* out, size_t n) {
+
+    T running{};
+    for (size_t i = 0; i < n; ++i) {
+        running += in[i];
+        out[i] = running;
+    }
+
+    T offset, total;
+    detail::scan_offset(comm, running, offset, total);
+    for (size_t i = 0; i < n; ++i) { out[i] += offset; }
+    return total;
+}
+
+///
+///@brief Distributed exclusive prefix sum of an array distributed over the processes in rank
+/// order, out[i] is the sum of all the elements before element i over all the ranks. Typically
+/// used to turn local counts into global offsets, e.g. to number cells or particles or to place
+/// variable-length records. Collective over the communicator.
+///
+///@tparam T arithmetic type with an MpiDatatype
+///@param comm the communicator
+///@param in local input elements
+///@param out local output elements, may be the same as in
+///@param n number of local elements
+///@return T the global sum
+///
+template <class T> T exclusive_scan(const Communicator& comm, const T* in, T* out, size_t n) {
+
+    T running{};
+    for (size_t i = 0; i < n; ++i) {
+        T value = in[i];
+        out[i]  = running;
+        running += value;
+    }
+
+    T offset, total;
+    detail::scan_offset(comm, running, offset, total);
+    for (size_t i = 0; i < n; ++i) { out[i] += offset; }
+    return total;
+}
+
+///
+///@brief Distributed segmented inclusive prefix sum, the sum restarts at every element with a
+/// non-zero head flag. Segments may span several ranks, the carry of the open segment is
+/// combined with MPI_Exscan and only the elements before the first local head are fixed up.
+/// Collective over the communicator.
+///
+///@tparam T arithmetic type
+///@param comm the communicator
+///@param in local input elements
+///@param heads local head flags, non-zero where a segment starts
+///@param out local output elements, may be the same as in
+///@param n number of local elements
+///
+template <class T>
+void segmented_inclusive_scan(
+    const Communicator& comm, const T* in, const uint8_t* heads, T* out, size_t n) {
+
+    T running{};
+    for (size_t i = 0; i < n; ++i) {
+        running = heads[i] ? in[i] : running + in[i];
+        out[i]  = running;
+    }
+    detail::segmented_fix_up(comm, heads, out, n, running);
+}
+
+///
+///@brief Distributed segmented exclusive prefix sum, out[i] is the sum of the elements of the
+/// segment of i before element i, i.e. zero at the segment heads. Compacts variable-length
+/// records grouped into segments (e.g. per cell or per owner) to offsets within their segment.
+/// Collective over the communicator.
+///
+///@tparam T arithmetic type
+///@param comm the communicator
+///@param in local input elements
+///@param heads local head flags, non-zero where a segment starts
+///@param out local output elements, may be the same as in
+///@param n number of local elements
+///
+template <class T>
+void segmented_exclusive_scan(
+    const Communicator& comm, const T* in, const uint8_t* heads, T* out, size_t n) {
+
+    T running{};
+    for (size_t i = 0; i < n; ++i) {
+        T value = in[i];
+        if (heads[i]) { running = T{}; }
+        out[i] = running;
+        running += value;
+    }
+    detail::segmented_fix_up(comm, heads, out, n, running);
+}
+
+} // namespace MpiWrapper
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "mpi_communicator.hpp"
+#include "mpi_functions.hpp"
+#include "runtime_assert.hpp"
+#include "space_filling_curve.hpp"
+
+namespace MpiWrapper {
+
+///
+///@brief Result of a space-filling-curve partitioning
+///
+struct SfcPartition {
+
+    ///
+    ///@brief New owner rank of each local item
+    ///
+    std::vector<int> owners;
+
+    ///
+    ///@brief Ownership map, rank p owns the keys [splitters[p], splitters[p + 1]). Empty ranks
+    /// get the splitter of the next non-empty rank.
+    ///
+    std::vector<uint64_t> splitters;
+
+    ///
+    ///@brief Get the owner of any key on the curve
+    ///
+    ///@param key the curve key
+    ///@return int the owner rank
+    ///
+    int owner_of(uint64_t key) const {
+        auto it = std::upper_bound(splitters.begin(), splitters.end(), key);
+        return it == splitters.begin() ? 0 : int(it - splitters.begin()) - 1;
+    }
+};
+
+///
+///@brief Partitions items (blocks, cells or particles) ordered along a space-filling curve into
+/// contiguous pieces of nearly equal total weight. The items have to be distributed in curve
+/// order, i.e. the local items are sorted by key and all the keys of rank r precede those of rank
+/// r + 1 (e.g. blocks enumerated along the curve, or after a distributed sort). The global
+/// position of every item is found with one MPI_Exscan of the local weights so the cost is
+/// O(n / P) plus O(P) for the ownership map. The curve order is verified with an MPI_Exscan of
+/// the last local keys.
+///
+///@param comm the communicator
+///@param keys curve keys of the local items, sorted
+///@param weights weights of the local items, empty for unit weights
+///@return SfcPartition new owners and the ownership map
+///@throws std::runtime_error on all ranks if the items are not in curve order
+///
+inline SfcPartition sfc_partition(const Communicator&           comm,
+                                  const std::vector<uint64_t>& keys,
+                                  const std::vector<double>&   weights = {}) {
+
+    Utils::runtime_assert(weights.empty() || weights.size() == keys.size(),
+                          "Weights do not match the keys.");
+
+    const size_t n       = keys.size();
+    const int    n_procs = comm.size();
+
+    // largest key of the ranks below, empty ranks contribute 0
+    uint64_t last     = n == 0 ? 0 : keys.back();
+    uint64_t previous = 0;
+    Mpi::exscan(&last, &previous, 1, MPI_UINT64_T, MPI_MAX, comm.get_handle());
+    if (comm.get_rank() == 0) { previous = 0; }
+    const bool ordered =
+        std::is_sorted(keys.begin(), keys.end()) && (n == 0 || keys.front() >= previous);
+
+    auto weight = [&](size_t i) { return weights.empty() ? 1.0 : weights[i]; };
+
+    double local = 0.0;
+    for (size_t i = 0; i < n; ++i) { local += weight(i); }
+
+    double offset = 0.0;
+    double total  = 0.0;
+    Mpi::exscan(&local, &offset, 1, MPI_DOUBLE, MPI_SUM, comm.get_handle());
+    Mpi::allreduce(&local, &total, 1, MPI_DOUBLE, MPI_SUM, comm.get_handle());
+    if (comm.get_rank() == 0) { offset = 0.0; }
+
+    SfcPartition ret;
+    ret.owners.resize(n);
+
+    // each item goes to the part containing the midpoint of its weight interval
+    const double scale = total > 0.0 ? double(n_procs) / total : 0.0;
+    double       begin = offset;
+    for (size_t i = 0; i < n; ++i) {
+        double w      = weight(i);
+        int    owner  = int((begin + 0.5 * w) * scale);
+        ret.owners[i] = std::min(owner, n_procs - 1);
+        begin += w;
+    }
+
+    // the first key of each part
+    constexpr uint64_t none = std::numeric_limits<uint64_t>::max();
+    // the order flag is reduced along with the splitters to save a collective
+    ret.splitters.assign(size_t(n_procs) + 1, none);
+    ret.splitters.back() = ordered ? 1 : 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (i == 0 || ret.owners[i] != ret.owners[i - 1]) {
+            auto p           = size_t(ret.owners[i]);
+            ret.splitters[p] = std::min(ret.splitters[p], keys[i]);
+        }
+    }
+    Mpi::allreduce(MPI_IN_PLACE,
+                   ret.splitters.data(),
+                   n_procs + 1,
+                   MPI_UINT64_T,
+                   MPI_MIN,
+                   comm.get_handle());
+    if (ret.splitters.back() == 0) { throw std::runtime_error("Items are not in curve order."); }
+    ret.splitters.pop_back();
+
+    for (size_t p = ret.splitters.size() - 1; p > 0; --p) {
+        if (ret.splitters[p - 1] == none) { ret.splitters[p - 1] = ret.splitters[p]; }
+    }
+
+    return ret;
+}
+
+} // namespace MpiWrapper
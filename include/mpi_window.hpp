@@ -0,0 +1,292 @@
+#pragma once
+
+#include <cstddef>
+
+#include <mpi.h>
+
+#include "mpi_communicator.hpp"
+#include "mpi_functions.hpp"
+#include "mpi_native_datatypes.hpp"
+#include "rma_epoch_checker.hpp"
+#include "runtime_assert.hpp"
+
+namespace MpiWrapper {
+
+///
+///@brief Owning wrapper around an RMA window allocated with MPI_Win_allocate. The window holds
+/// count elements of type T on each process and is accessed with typed one-sided operations
+/// inside passive-target epochs (lock_all/unlock_all or lock/unlock of a single target).
+/// Displacements are given in elements. The window is move-only and is freed on destruction, all
+/// the epochs have to be closed by then.
+///
+/// In debug builds an epoch checker throws on operations outside of an epoch and on unmatched
+/// lock/unlock calls, in release builds the checks compile away.
+///
+///@tparam T element type with an MpiDatatype
+///
+template <class T> class Window {
+public:
+    Window() = default;
+
+    ///
+    ///@brief Construct a new Window, collective over the communicator
+    ///
+    ///@param comm the communicator
+    ///@param count number of local elements
+    ///@param info info object with hints, default = MPI_INFO_NULL
+    ///
+    Window(const Communicator& comm, size_t count, MPI_Info info = MPI_INFO_NULL)
+        : m_comm(comm)
+        , m_count(count) {
+        m_handle = Mpi::win_allocate(
+            MPI_Aint(count * sizeof(T)), int(sizeof(T)), info, m_comm.get_handle(), &m_data);
+    }
+
+    Window(const Window& other) = delete;
+    Window& operator=(const Window& other) = delete;
+
+    Window(Window&& other) noexcept
+        : m_comm(std::move(other.m_comm))
+        , m_handle(other.m_handle)
+        , m_data(other.m_data)
+        , m_count(other.m_count)
+        , m_epochs(std::move(other.m_epochs)) {
+        other.m_handle = MPI_WIN_NULL;
+        other.m_data   = nullptr;
+        other.m_count  = 0;
+    }
+
+    Window& operator=(Window&& other) noexcept {
+        if (this != &other) {
+            free();
+            m_comm         = std::move(other.m_comm);
+            m_handle       = other.m_handle;
+            m_data         = other.m_data;
+            m_count        = other.m_count;
+            m_epochs       = std::move(other.m_epochs);
+            other.m_handle = MPI_WIN_NULL;
+            other.m_data   = nullptr;
+            other.m_count  = 0;
+        }
+        return *this;
+    }
+
+    ~Window() { free(); }
+
+    ///
+    ///@brief Starts a shared epoch to all the processes (MPI_Win_lock_all)
+    ///
+    ///@param assert_flags assertions, default = 0
+    ///
+    void lock_all(int assert_flags = 0) {
+        m_epochs.lock_all();
+        Mpi::win_lock_all(assert_flags, m_handle);
+    }
+
+    ///
+    ///@brief Ends the epoch to all the processes (MPI_Win_unlock_all), completes all the
+    /// operations
+    ///
+    void unlock_all() {
+        m_epochs.unlock_all();
+        Mpi::win_unlock_all(m_handle);
+    }
+
+    ///
+    ///@brief Starts an epoch to a single target (MPI_Win_lock)
+    ///
+    ///@param rank the target rank
+    ///@param exclusive true for an exclusive lock, default = false
+    ///@param assert_flags assertions, default = 0
+    ///
+    void lock(int rank, bool exclusive = false, int assert_flags = 0) {
+        m_epochs.lock(rank);
+        Mpi::win_lock(
+            exclusive ? MPI_LOCK_EXCLUSIVE : MPI_LOCK_SHARED, rank, assert_flags, m_handle);
+    }
+
+    ///
+    ///@brief Ends the epoch to a single target (MPI_Win_unlock), completes the operations
+    ///
+    ///@param rank the target rank
+    ///
+    void unlock(int rank) {
+        m_epochs.unlock(rank);
+        Mpi::win_unlock(rank, m_handle);
+    }
+
+    ///
+    ///@brief Completes the outstanding operations to a target, at the origin and at the target
+    ///
+    ///@param rank the target rank
+    ///
+    void flush(int rank) {
+        m_epochs.access(rank);
+        Mpi::win_flush(rank, m_handle);
+    }
+
+    ///
+    ///@brief Completes the outstanding operations to all the targets
+    ///
+    void flush_all() {
+        m_epochs.access_any();
+        Mpi::win_flush_all(m_handle);
+    }
+
+    ///
+    ///@brief Completes the outstanding operations to a target at the origin only, the origin
+    /// buffers can be reused afterwards
+    ///
+    ///@param rank the target rank
+    ///
+    void flush_local(int rank) {
+        m_epochs.access(rank);
+        Mpi::win_flush_local(rank, m_handle);
+    }
+
+    ///
+    ///@brief Synchronizes the public and private copies of the local window, needed before
+    /// reading data() that other processes have written within an epoch
+    ///
+    void sync() { Mpi::win_sync(m_handle); }
+
+    ///
+    ///@brief Writes count elements to the window of a target, completes with flush or unlock
+    ///
+    ///@param origin local data, must stay valid until completion
+    ///@param count number of elements
+    ///@param rank the target rank
+    ///@param disp displacement in elements in the target window
+    ///
+    void put(const T* origin, size_t count, int rank, size_t disp) {
+        m_epochs.access(rank);
+        Mpi::put(origin, int(count), MpiDatatype<T>::get_handle(), rank, MPI_Aint(disp), m_handle);
+    }
+
+    ///
+    ///@brief Reads count elements from the window of a target, completes with flush or unlock
+    ///
+    ///@param origin local buffer, valid after completion
+    ///@param count number of elements
+    ///@param rank the target rank
+    ///@param disp displacement in elements in the target window
+    ///
+    void get(T* origin, size_t count, int rank, size_t disp) {
+        m_epochs.access(rank);
+        Mpi::get(origin, int(count), MpiDatatype<T>::get_handle(), rank, MPI_Aint(disp), m_handle);
+    }
+
+    ///
+    ///@brief Atomically combines count elements into the window of a target, completes with
+    /// flush or unlock
+    ///
+    ///@param origin local data, must stay valid until completion
+    ///@param count number of elements
+    ///@param rank the target rank
+    ///@param disp displacement in elements in the target window
+    ///@param op predefined reduction operation, default = MPI_SUM
+    ///
+    void accumulate(const T* origin, size_t count, int rank, size_t disp, MPI_Op op = MPI_SUM) {
+        m_epochs.access(rank);
+        Mpi::accumulate(
+            origin, int(count), MpiDatatype<T>::get_handle(), rank, MPI_Aint(disp), op, m_handle);
+    }
+
+    ///
+    ///@brief Reads from the window of a target with a derived target layout, e.g. scattered
+    /// blocks gathered into a contiguous local buffer, completes with flush or unlock
+    ///
+    ///@param origin local buffer, valid after completion
+    ///@param count number of elements described by target_type
+    ///@param rank the target rank
+    ///@param target_type layout of the elements in the target window, relative to element 0
+    ///
+    template <class DT>
+    void get(T* origin, size_t count, int rank, const MpiDatatypeBase<DT>& target_type) {
+        m_epochs.access(rank);
+        Mpi::get(origin,
+                 int(count),
+                 MpiDatatype<T>::get_handle(),
+                 rank,
+                 0,
+                 1,
+                 ~target_type,
+                 m_handle);
+    }
+
+    ///
+    ///@brief Atomically replaces an element of the window of a target if it equals compare,
+    /// completes with flush or unlock. T has to be a predefined integer type.
+    ///
+    ///@param value the new value, must stay valid until completion
+    ///@param compare the value to compare with, must stay valid until completion
+    ///@param result output, the previous value of the target element, valid after completion
+    ///@param rank the target rank
+    ///@param disp displacement in elements in the target window
+    ///
+    void compare_and_swap(const T* value, const T* compare, T* result, int rank, size_t disp) {
+        m_epochs.access(rank);
+        Mpi::compare_and_swap(
+            value, compare, result, MpiDatatype<T>::get_handle(), rank, MPI_Aint(disp), m_handle);
+    }
+
+    ///
+    ///@brief Atomically combines a value into an element of the window of a target, completes
+    /// with flush or unlock
+    ///
+    ///@param value the value to combine, must stay valid until completion
+    ///@param result output, the previous value of the target element, valid after completion
+    ///@param rank the target rank
+    ///@param disp displacement in elements in the target window
+    ///@param op predefined reduction operation, default = MPI_SUM
+    ///
+    void fetch_and_op(const T* value, T* result, int rank, size_t disp, MPI_Op op = MPI_SUM) {
+        m_epochs.access(rank);
+        Mpi::fetch_and_op(
+            value, result, MpiDatatype<T>::get_handle(), rank, MPI_Aint(disp), op, m_handle);
+    }
+
+    ///
+    ///@brief Get the local memory of the window
+    ///
+    ///@return T* pointer to the local elements
+    ///
+    T*       data() { return m_data; }
+    const T* data() const { return m_data; }
+
+    ///
+    ///@brief Get the number of local elements
+    ///
+    ///@return size_t number of elements
+    ///
+    size_t size() const { return m_count; }
+
+    ///
+    ///@brief Get the communicator of the window
+    ///
+    ///@return const Communicator& the communicator
+    ///
+    const Communicator& get_communicator() const { return m_comm; }
+
+    ///
+    ///@brief Get the mpi-handle
+    ///
+    ///@return MPI_Win handle
+    ///
+    MPI_Win get_handle() const { return m_handle; }
+
+private:
+    Communicator        m_comm{Communicator::borrow(MPI_COMM_NULL)};
+    MPI_Win             m_handle = MPI_WIN_NULL;
+    T*                  m_data   = nullptr;
+    size_t              m_count  = 0;
+    Utils::EpochChecker m_epochs;
+
+    void free() {
+        if (m_handle != MPI_WIN_NULL && !Mpi::finalized()) { Mpi::win_free(m_handle); }
+        m_handle = MPI_WIN_NULL;
+        m_data   = nullptr;
+    }
+};
+
+} // namespace MpiWrapper
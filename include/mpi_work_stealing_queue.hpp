@@ -0,0 +1,240 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "mpi_communicator.hpp"
+#include "mpi_global_counter.hpp"
+#include "mpi_window.hpp"
+
+namespace MpiWrapper {
+
+///
+///@brief Distributed work-stealing queue. Every process owns a ring buffer of tasks in an RMA
+/// window, it pushes and pops its own tasks at the tail and idle processes steal half of the
+/// tasks of a random victim from the head, without involving the victim. The ring and its
+/// head/tail counters are modified under an exclusive lock of the owning process.
+///
+/// Termination is detected with a GlobalCounter of the outstanding tasks: pushes increment it
+/// eagerly, completions are reported in batches when the local queue runs empty, and the
+/// processing ends when the counter reaches zero. Tasks may push new tasks while they run.
+///
+///@tparam Task trivially copyable task description
+///
+template <class Task> class WorkStealingQueue {
+
+    static_assert(std::is_trivially_copyable_v<Task>, "Tasks have to be trivially copyable.");
+
+public:
+    ///
+    ///@brief Construct a new Work Stealing Queue, collective over the communicator
+    ///
+    ///@param comm the communicator
+    ///@param capacity maximum number of queued tasks per process
+    ///@param seed seed of the victim selection, default = 0
+    ///
+    WorkStealingQueue(const Communicator& comm, size_t capacity, unsigned seed = 0)
+        : m_comm(comm)
+        , m_capacity(capacity)
+        , m_outstanding(comm)
+        , m_tasks(comm, capacity * sizeof(Task))
+        , m_ends(comm, 2)
+        , m_random(seed + unsigned(comm.get_rank())) {
+        Utils::runtime_assert(capacity > 0, "Invalid queue capacity.");
+        m_ends.data()[head] = 0;
+        m_ends.data()[tail] = 0;
+        Mpi::barrier(m_comm.get_handle());
+    }
+
+    ///
+    ///@brief Pushes a task to the local queue
+    ///
+    ///@param task the task
+    ///
+    void push(const Task& task) { push(std::vector<Task>{task}); }
+
+    ///
+    ///@brief Pushes a batch of tasks to the local queue, throws std::runtime_error if the queue
+    /// is full
+    ///
+    ///@param tasks the tasks
+    ///
+    void push(const std::vector<Task>& tasks) {
+        if (tasks.empty()) { return; }
+
+        const int rank = m_comm.get_rank();
+        m_tasks.lock(rank, true);
+        m_ends.lock(rank, true);
+        m_ends.sync();
+        long* ends = m_ends.data();
+        if (ends[tail] - ends[head] + long(tasks.size()) > long(m_capacity)) {
+            m_ends.unlock(rank);
+            m_tasks.unlock(rank);
+            throw std::runtime_error("Work stealing queue is full.");
+        }
+        for (const auto& task : tasks) {
+            std::memcpy(slot(ends[tail]), &task, sizeof(Task));
+            ++ends[tail];
+        }
+        // counted before the tasks can be stolen and completed elsewhere
+        m_outstanding.fetch_add(int64_t(tasks.size()));
+        m_tasks.sync();
+        m_ends.sync();
+        m_ends.unlock(rank);
+        m_tasks.unlock(rank);
+    }
+
+    ///
+    ///@brief Processes the tasks of all the processes until no task is left, collective over the
+    /// communicator. The initial tasks have to be pushed before.
+    ///
+    ///@param f called with every task, may push new tasks
+    ///
+    template <class Function> void run(Function f) {
+
+        Mpi::barrier(m_comm.get_handle());
+
+        int64_t completed = 0;
+        while (true) {
+            if (auto task = pop()) {
+                f(*task);
+                ++completed;
+                continue;
+            }
+            if (completed > 0) {
+                m_outstanding.fetch_add(-completed);
+                completed = 0;
+            }
+            if (m_outstanding.load() == 0) { break; }
+            steal();
+        }
+
+        Mpi::barrier(m_comm.get_handle());
+    }
+
+    ///
+    ///@brief Get the number of tasks in the local queue
+    ///
+    ///@return size_t number of queued tasks
+    ///
+    size_t local_size() {
+        const int rank = m_comm.get_rank();
+        m_ends.lock(rank, true);
+        m_ends.sync();
+        auto n = size_t(m_ends.data()[tail] - m_ends.data()[head]);
+        m_ends.unlock(rank);
+        return n;
+    }
+
+    ///
+    ///@brief Get the number of tasks this process has stolen from others
+    ///
+    ///@return size_t number of stolen tasks
+    ///
+    size_t stolen() const { return m_stolen; }
+
+private:
+    static constexpr size_t head = 0;
+    static constexpr size_t tail = 1;
+
+    Communicator          m_comm;
+    size_t                m_capacity;
+    GlobalCounter         m_outstanding;
+    Window<unsigned char> m_tasks;
+    Window<long>          m_ends;
+    std::minstd_rand      m_random;
+    size_t                m_stolen = 0;
+
+    unsigned char* slot(long i) {
+        return m_tasks.data() + size_t(i) % m_capacity * sizeof(Task);
+    }
+
+    ///
+    ///@brief Pops the newest local task
+    ///
+    std::optional<Task> pop() {
+        const int rank = m_comm.get_rank();
+        m_tasks.lock(rank, true);
+        m_ends.lock(rank, true);
+        m_tasks.sync();
+        m_ends.sync();
+
+        std::optional<Task> ret;
+        long*               ends = m_ends.data();
+        if (ends[tail] > ends[head]) {
+            --ends[tail];
+            Task task;
+            std::memcpy(&task, slot(ends[tail]), sizeof(Task));
+            ret = task;
+            m_ends.sync();
+        }
+        m_ends.unlock(rank);
+        m_tasks.unlock(rank);
+        return ret;
+    }
+
+    ///
+    ///@brief Moves half of the tasks of a random victim to the local queue
+    ///
+    void steal() {
+        const int n_procs = m_comm.size();
+        if (n_procs == 1) { return; }
+
+        const int rank   = m_comm.get_rank();
+        int       victim = int(m_random() % unsigned(n_procs - 1));
+        if (victim >= rank) { ++victim; }
+
+        std::vector<unsigned char> loot;
+        m_tasks.lock(victim, true);
+        m_ends.lock(victim, true);
+
+        long ends[2];
+        m_ends.get(ends, 2, victim, 0);
+        m_ends.flush(victim);
+
+        const long available = ends[tail] - ends[head];
+        const long n         = (available + 1) / 2;
+        if (n > 0) {
+            loot.resize(size_t(n) * sizeof(Task));
+            // the stolen range may wrap around the end of the ring
+            const size_t first = size_t(ends[head]) % m_capacity;
+            const size_t n1    = std::min(size_t(n), m_capacity - first);
+            m_tasks.get(loot.data(), n1 * sizeof(Task), victim, first * sizeof(Task));
+            if (n1 < size_t(n)) {
+                m_tasks.get(loot.data() + n1 * sizeof(Task),
+                            (size_t(n) - n1) * sizeof(Task),
+                            victim,
+                            0);
+            }
+            long new_head = ends[head] + n;
+            m_ends.put(&new_head, 1, victim, head);
+        }
+        m_ends.unlock(victim);
+        m_tasks.unlock(victim);
+
+        if (n == 0) { return; }
+
+        // the stolen tasks are already counted as outstanding
+        m_tasks.lock(rank, true);
+        m_ends.lock(rank, true);
+        m_ends.sync();
+        long* local = m_ends.data();
+        for (long i = 0; i < n; ++i) {
+            std::memcpy(slot(local[tail]), loot.data() + size_t(i) * sizeof(Task), sizeof(Task));
+            ++local[tail];
+        }
+        m_tasks.sync();
+        m_ends.sync();
+        m_ends.unlock(rank);
+        m_tasks.unlock(rank);
+        m_stolen += size_t(n);
+    }
+};
+
+} // namespace MpiWrapper
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace MpiWrapper::Utils {
+
+///
+///@brief Block of a strided N-dimensional storage, the user-space counterpart of a subarray
+/// datatype. The last stride has to be 1, i.e. the rows of the last direction are contiguous.
+///
+///@tparam N number of dimensions
+///
+template <size_t N> struct SubarrayLayout {
+    std::array<size_t, N> extents{};  // elements of the block per direction
+    std::array<size_t, N> strides{};  // element strides of the storage
+    size_t                offset = 0; // storage index of the first element of the block
+
+    size_t size() const {
+        size_t ret = 1;
+        for (auto e : extents) { ret *= e; }
+        return ret;
+    }
+};
+
+///
+///@brief Packs larger than this many bytes use non-temporal stores, the packed buffer is only
+/// read by the network and should not evict the working set from the cache
+///
+constexpr size_t streaming_threshold = size_t(1) << 20;
+
+namespace detail {
+
+///
+///@brief Calls f(storage_offset, buffer_offset) for every block of the M innermost directions,
+/// the outer indices are advanced like an odometer without divisions
+///
+template <size_t M, size_t N, class F> void for_each_block(const SubarrayLayout<N>& l, F f) {
+    static_assert(M >= 1 && M <= N, "Invalid block dimension.");
+
+    size_t block = 1, count = 1;
+    for (size_t d = N - M; d < N; ++d) { block *= l.extents[d]; }
+    for (size_t d = 0; d < N - M; ++d) { count *= l.extents[d]; }
+    if (block == 0 || count == 0) { return; }
+
+    std::array<size_t, N> idx{};
+    size_t                pos = l.offset;
+    for (size_t b = 0; b < count; ++b) {
+        f(pos, b * block);
+        for (size_t d = N - M; d-- > 0;) {
+            pos += l.strides[d];
+            if (++idx[d] < l.extents[d]) { break; }
+            pos -= l.strides[d] * l.extents[d];
+            idx[d] = 0;
+        }
+    }
+}
+
+///
+///@brief Copies bytes with non-temporal vector stores, the unaligned head and tail of the
+/// destination are copied normally
+///
+inline void stream_copy(const unsigned char* src, size_t n, unsigned char* dst) {
+#if defined(__AVX__)
+    constexpr size_t width = 32;
+#elif defined(__SSE2__)
+    constexpr size_t width = 16;
+#else
+    constexpr size_t width = 1;
+#endif
+    size_t i = (width - reinterpret_cast<uintptr_t>(dst) % width) % width;
+    if (i > n) { i = n; }
+    std::memcpy(dst, src, i);
+#if defined(__AVX__)
+    for (; i + width <= n; i += width) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(static_cast<void*>(dst + i)), v);
+    }
+#elif defined(__SSE2__)
+    for (; i + width <= n; i += width) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_stream_si128(reinterpret_cast<__m128i*>(static_cast<void*>(dst + i)), v);
+    }
+#endif
+    std::memcpy(dst + i, src + i, n - i);
+}
+
+///
+///@brief Orders the non-temporal stores before the following stores, e.g. the send
+///
+inline void stream_fence() {
+#if defined(__SSE2__)
+    _mm_sfence();
+#endif
+}
+
+///
+///@brief Copies the blocks of the two innermost directions with rows of compile-time width W,
+/// e.g. the halo of the last direction. The fixed width unrolls the row loop.
+///
+template <size_t W, bool Pack, class A, class B, size_t N>
+void copy_narrow(A* array, const SubarrayLayout<N>& l, B* buffer) {
+    const size_t rows   = l.extents[N - 2];
+    const size_t stride = l.strides[N - 2];
+    for_each_block<2>(l, [&](size_t pos, size_t buf) {
+        A* a = array + pos;
+        B* b = buffer + buf;
+        for (size_t r = 0; r < rows; ++r, a += stride, b += W) {
+            for (size_t w = 0; w < W; ++w) {
+                if constexpr (Pack) {
+                    b[w] = a[w];
+                } else {
+                    a[w] = b[w];
+                }
+            }
+        }
+    });
+}
+
+///
+///@brief Dispatches narrow rows (at most 4 elements) to the fixed-width kernels
+///
+///@return true if the layout has been copied
+///
+template <bool Pack, class A, class B, size_t N>
+bool dispatch_narrow(A* array, const SubarrayLayout<N>& l, B* buffer) {
+    if constexpr (N < 2) {
+        return false;
+    } else {
+        switch (l.extents[N - 1]) {
+        case 1: copy_narrow<1, Pack>(array, l, buffer); return true;
+        case 2: copy_narrow<2, Pack>(array, l, buffer); return true;
+        case 3: copy_narrow<3, Pack>(array, l, buffer); return true;
+        case 4: copy_narrow<4, Pack>(array, l, buffer); return true;
+        default: return false;
+        }
+    }
+}
+
+} // namespace detail
+
+///
+///@brief Copies a block of a strided array into a contiguous buffer in C order, the same byte
+/// stream as MPI_Pack of the corresponding subarray datatype. Narrow rows use kernels
+/// specialised for the row width, wide rows are copied with memcpy or, for packs above
+/// streaming_threshold, with non-temporal vector stores.
+///
+///@param base the storage
+///@param l the block
+///@param out buffer of l.size() elements
+///
+template <class T, size_t N> void pack(const T* base, const SubarrayLayout<N>& l, T* out) {
+    static_assert(std::is_trivially_copyable_v<T>, "Packing of trivially copyable types only.");
+
+    if (detail::dispatch_narrow<true>(base, l, out)) { return; }
+
+    const size_t row    = l.extents[N - 1];
+    const bool   stream = l.size() * sizeof(T) >= streaming_threshold;
+    detail::for_each_block<1>(l, [&](size_t pos, size_t buf) {
+        if (stream) {
+            detail::stream_copy(reinterpret_cast<const unsigned char*>(base + pos),
+                                row * sizeof(T),
+                                reinterpret_cast<unsigned char*>(out + buf));
+        } else {
+            std::memcpy(out + buf, base + pos, row * sizeof(T));
+        }
+    });
+    if (stream) { detail::stream_fence(); }
+}
+
+///
+///@brief Copies a contiguous C-order buffer into a block of a strided array, the inverse of
+/// pack(). Regular stores are used since the unpacked data is read soon after.
+///
+///@param in buffer of l.size() elements
+///@param l the block
+///@param base the storage
+///
+template <class T, size_t N> void unpack(const T* in, const SubarrayLayout<N>& l, T* base) {
+    static_assert(std::is_trivially_copyable_v<T>, "Packing of trivially copyable types only.");
+
+    if (detail::dispatch_narrow<false>(base, l, in)) { return; }
+
+    const size_t row = l.extents[N - 1];
+    detail::for_each_block<1>(
+        l, [&](size_t pos, size_t buf) { std::memcpy(base + pos, in + buf, row * sizeof(T)); });
+}
+
+} // namespace MpiWrapper::Utils
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <set>
+
+#include "runtime_assert.hpp"
+
+namespace MpiWrapper::Utils {
+
+#ifdef DEBUG
+///
+///@brief Tracks the passive-target epochs of a window and throws on accesses outside of an
+/// epoch, on nested or unmatched lock/unlock calls and on flushes without an epoch.
+///
+class EpochChecker {
+public:
+    void lock_all() {
+        runtime_assert(!m_all && m_locked.empty(), "Window is already locked.");
+        m_all = true;
+    }
+
+    void unlock_all() {
+        runtime_assert(m_all, "Window unlock_all without lock_all.");
+        m_all = false;
+    }
+
+    void lock(int rank) {
+        runtime_assert(!m_all && m_locked.count(rank) == 0, "Window target is already locked.");
+        m_locked.insert(rank);
+    }
+
+    void unlock(int rank) {
+        runtime_assert(m_locked.erase(rank) == 1, "Window unlock without lock.");
+    }
+
+    void access(int rank) const {
+        runtime_assert(m_all || m_locked.count(rank) == 1, "RMA access outside of an epoch.");
+    }
+
+    void access_any() const {
+        runtime_assert(m_all || !m_locked.empty(), "RMA access outside of an epoch.");
+    }
+
+private:
+    bool          m_all = false;
+    std::set<int> m_locked;
+};
+#else
+///
+///@brief Release version of the epoch checker, all the checks compile away
+///
+class EpochChecker {
+public:
+    constexpr void lock_all() {}
+    constexpr void unlock_all() {}
+    constexpr void lock([[maybe_unused]] int rank) {}
+    constexpr void unlock([[maybe_unused]] int rank) {}
+    constexpr void access([[maybe_unused]] int rank) const {}
+    constexpr void access_any() const {}
+};
+#endif
+
+} // namespace MpiWrapper::Utils
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+namespace MpiWrapper::Utils {
+
+///
+///@brief Spreads the lowest 64 / N bits of x so that there are N - 1 zero bits between
+/// consecutive bits, i.e. bit j of x moves to bit j * N. Branch-free so that loops over many
+/// coordinates vectorize.
+///
+///@tparam N number of dimensions, 1, 2 or 3
+///@param x the value to spread
+///@return uint64_t the spread bits
+///
+template <size_t N> constexpr uint64_t spread_bits(uint64_t x) {
+    static_assert(N >= 1 && N <= 3, "Spreading implemented for 1, 2 and 3 dimensions.");
+    if constexpr (N == 1) {
+        return x;
+    } else if constexpr (N == 2) {
+        x &= 0x00000000ffffffffull;
+        x = (x | (x << 16)) & 0x0000ffff0000ffffull;
+        x = (x | (x << 8)) & 0x00ff00ff00ff00ffull;
+        x = (x | (x << 4)) & 0x0f0f0f0f0f0f0f0full;
+        x = (x | (x << 2)) & 0x3333333333333333ull;
+        x = (x | (x << 1)) & 0x5555555555555555ull;
+        return x;
+    } else {
+        x &= 0x00000000001fffffull;
+        x = (x | (x << 32)) & 0x001f00000000ffffull;
+        x = (x | (x << 16)) & 0x001f0000ff0000ffull;
+        x = (x | (x << 8)) & 0x100f00f00f00f00full;
+        x = (x | (x << 4)) & 0x10c30c30c30c30c3ull;
+        x = (x | (x << 2)) & 0x1249249249249249ull;
+        return x;
+    }
+}
+
+///
+///@brief Maximum number of bits per coordinate that fit into a 64-bit key and a uint32_t coordinate
+///
+template <size_t N> constexpr uint32_t max_curve_bits = uint32_t(64 / N < 32 ? 64 / N : 32);
+
+///
+///@brief Morton (Z-order) key of the coordinates. The bits are interleaved so that direction 0
+/// is the most significant within each level.
+///
+///@tparam N number of dimensions
+///@param coords the coordinates, at most max_curve_bits<N> bits each
+///@return uint64_t the key
+///
+template <size_t N> constexpr uint64_t morton_key(const std::array<uint32_t, N>& coords) {
+    uint64_t key = 0;
+    for (size_t i = 0; i < N; ++i) { key |= spread_bits<N>(coords[i]) << (N - 1 - i); }
+    return key;
+}
+
+///
+///@brief Hilbert key of the coordinates using the transpose algorithm of J. Skilling
+/// ("Programming the Hilbert curve", 2004). The coordinates are transformed in place with
+/// branch-free bit operations and then interleaved like a Morton key.
+///
+///@tparam N number of dimensions
+///@param coords the coordinates, less than 2^bits each
+///@param bits number of bits per coordinate (levels of the curve), at most max_curve_bits<N>,
+/// a curve with 0 bits has the single key 0
+///@return uint64_t the key
+///@throws std::invalid_argument if bits exceeds max_curve_bits<N>
+///
+template <size_t N>
+constexpr uint64_t hilbert_key(std::array<uint32_t, N> coords, uint32_t bits) {
+
+    if (bits > max_curve_bits<N>) { throw std::invalid_argument("Too many bits for the curve."); }
+    if (bits == 0) { return 0; }
+    const uint32_t top = uint32_t(1) << (bits - 1);
+
+    // inverse undo
+    for (uint32_t q = top; q > 1; q >>= 1) {
+        const uint32_t p = q - 1;
+        for (size_t i = 0; i < N; ++i) {
+            const uint32_t invert = 0u - uint32_t((coords[i] & q) != 0);
+            coords[0] ^= p & invert;
+            const uint32_t t = (coords[0] ^ coords[i]) & p & ~invert;
+            coords[0] ^= t;
+            coords[i] ^= t;
+        }
+    }
+
+    // gray encode
+    for (size_t i = 1; i < N; ++i) { coords[i] ^= coords[i - 1]; }
+    uint32_t t = 0;
+    for (uint32_t q = top; q > 1; q >>= 1) {
+        t ^= (q - 1) & (0u - uint32_t((coords[N - 1] & q) != 0));
+    }
+    for (size_t i = 0; i < N; ++i) { coords[i] ^= t; }
+
+    return morton_key<N>(coords);
+}
+
+///
+///@brief Computes the Morton keys of n coordinate tuples
+///
+///@param coords input coordinates
+///@param keys output keys
+///@param n number of tuples
+///
+template <size_t N>
+void morton_keys(const std::array<uint32_t, N>* coords, uint64_t* keys, size_t n) {
+    for (size_t i = 0; i < n; ++i) { keys[i] = morton_key<N>(coords[i]); }
+}
+
+///
+///@brief Computes the Hilbert keys of n coordinate tuples
+///
+///@param coords input coordinates
+///@param keys output keys
+///@param n number of tuples
+///@param bits number of bits per coordinate
+///
+template <size_t N>
+void hilbert_keys(const std::array<uint32_t, N>* coords, uint64_t* keys, size_t n, uint32_t bits) {
+    for (size_t i = 0; i < n; ++i) { keys[i] = hilbert_key<N>(coords[i], bits); }
+}
+
+} // namespace MpiWrapper::Utils
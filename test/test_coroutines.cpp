@@ -0,0 +1,133 @@
+#include "catch.hpp"
+
+#include <coroutine>
+#include <cstdio>
+#include <exception>
+#include <string>
+
+#include "mpi_array_io.hpp"
+#include "mpi_checkpoint_writer.hpp"
+#include "mpi_communicator.hpp"
+#include "mpi_native_datatypes.hpp"
+#include "mpi_request_scheduler.hpp"
+
+namespace {
+
+//fire-and-forget coroutine, runs eagerly up to the first suspension
+struct Task {
+    struct promise_type {
+        Task               get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void               return_void() {}
+        void               unhandled_exception() { std::terminate(); }
+    };
+};
+
+Task receive(MpiWrapper::Communicator& comm, int* value, int source, int& stage) {
+    using namespace MpiWrapper;
+    stage = 1;
+    co_await comm.irecv(value, 1, MpiDatatype<int>(), source);
+    stage = 2;
+    co_await comm.irecv(value + 1, 1, MpiDatatype<int>(), source, 2);
+    stage = 3;
+}
+
+Task await_checkpoint(MpiWrapper::CheckpointWriter& writer, size_t id, bool& done) {
+    co_await writer.async(id);
+    done = true;
+}
+
+//awaiting code may close the files right after the resumption
+Task await_and_close(MpiWrapper::CheckpointWriter& writer, size_t id, bool& done) {
+    co_await writer.async(id);
+    writer.wait_all();
+    done = true;
+}
+
+} // namespace
+
+TEST_CASE("co_await Request"){
+
+    using namespace MpiWrapper;
+
+    Communicator comm;
+    int rank = comm.get_rank();
+    int size = comm.size();
+    int right = (rank + 1) % size;
+    int left = (rank - 1 + size) % size;
+
+    //nothing has been sent yet, the coroutine suspends on the irecv
+    int values[2] = {-1, -1};
+    int stage = 0;
+    receive(comm, values, left, stage);
+    CHECK(stage == 1);
+    CHECK(RequestScheduler::this_thread().pending() == 1);
+    MPI_Barrier(comm.get_handle());
+
+    int sent[2] = {rank, 100 + rank};
+    auto first = comm.isend(&sent[0], 1, MpiDatatype<int>(), right);
+    while (stage == 1) { RequestScheduler::this_thread().progress(); }
+    CHECK(values[0] == left);
+
+    //the resumed coroutine awaits the second message, unless it has already arrived
+    CHECK(stage >= 2);
+    auto second = comm.isend(&sent[1], 1, MpiDatatype<int>(), right, 2);
+    RequestScheduler::this_thread().run();
+    CHECK(stage == 3);
+    CHECK(values[1] == 100 + left);
+
+    first.wait();
+    second.wait();
+
+}
+
+TEST_CASE("co_await CheckpointWriter"){
+
+    using namespace MpiWrapper;
+
+    size_t world_size = static_cast<size_t>(Mpi::world_size());
+    CartCommunicator<2> slabs({world_size, 1}, {0, 0}, 0);
+    std::array<size_t, 2> global{2 * world_size + 1, 5};
+
+    DistributedArray<int, 2> arr(slabs, global, 1);
+    auto ext = arr.local_extents();
+    for (int i = 0; i < int(ext[0]); ++i){
+    for (int j = 0; j < int(ext[1]); ++j){
+        auto g = arr.local_to_global({i, j});
+        arr({i, j}) = int(100 * g[0] + g[1]);
+    }}
+
+    const std::string path = "mpi_wrapper_checkpoint_coroutine.bin";
+    {
+        RequestScheduler scheduler;
+        CheckpointWriter writer(2, FileHints(), scheduler);
+        auto id = writer.write(arr, path);
+
+        //the coroutine is resumed from the progress() of the scheduler
+        bool done = false;
+        await_checkpoint(writer, id, done);
+        while (!done) { scheduler.progress(); }
+        CHECK(writer.test(id));
+        writer.wait_all();
+
+        //the coroutine retires the checkpoint it has been resumed for
+        bool closed = false;
+        id = writer.write(arr, path);
+        await_and_close(writer, id, closed);
+        while (!closed) { scheduler.progress(); }
+        CHECK(writer.in_flight() == 0);
+    }
+
+    DistributedArray<int, 2> in(slabs, global);
+    read_array(path, in);
+    for (int i = 0; i < int(ext[0]); ++i){
+    for (int j = 0; j < int(ext[1]); ++j){
+        auto g = in.local_to_global({i, j});
+        CHECK(in({i, j}) == int(100 * g[0] + g[1]));
+    }}
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (slabs.get_rank() == 0) { std::remove(path.c_str()); }
+
+}
@@ -0,0 +1,79 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "mpi_checkpoint.hpp"
+
+//serial tools, MPI is never initialized
+
+namespace {
+
+void write_file(const std::string&                  path,
+                const MpiWrapper::CheckpointHeader& header,
+                const std::vector<float>&           data) {
+    std::vector<unsigned char> block(MpiWrapper::CheckpointHeader::size_in_file, 0);
+    std::memcpy(block.data(), &header, sizeof(header));
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    REQUIRE(f != nullptr);
+    std::fwrite(block.data(), 1, block.size(), f);
+    std::fwrite(data.data(), sizeof(float), data.size(), f);
+    std::fclose(f);
+}
+
+} // namespace
+
+TEST_CASE("MappedCheckpoint without MPI"){
+
+    using namespace MpiWrapper;
+
+    REQUIRE(!Mpi::initialized());
+
+    const std::string path = "mpi_wrapper_serial_checkpoint.bin";
+
+    CheckpointHeader header;
+    header.n_dims = 2;
+    header.element_size = uint32_t(sizeof(float));
+    std::strcpy(header.type_name, "MPI_FLOAT");
+    header.global_extents[0] = 3;
+    header.global_extents[1] = 4;
+
+    std::vector<float> data(12);
+    for (size_t i = 0; i < data.size(); ++i) { data[i] = float(i); }
+    write_file(path, header, data);
+
+    {
+        MappedCheckpoint<float, 2> mapped(path);
+        CHECK(mapped.global_extents() == std::array<size_t, 2>{3, 4});
+        CHECK(mapped({2, 1}) == 9.0f);
+        std::vector<float> block(4);
+        mapped.read_block({1, 1}, {2, 2}, block.data());
+        CHECK(block == std::vector<float>{5.0f, 6.0f, 9.0f, 10.0f});
+    }
+    //without MPI the size and the dimension are checked
+    REQUIRE_THROWS(MappedCheckpoint<double, 2>(path));
+    REQUIRE_THROWS(MappedCheckpoint<float, 3>(path));
+
+    //corrupt extents or offsets must not overflow the size check
+    CheckpointHeader huge = header;
+    huge.global_extents[0] = uint64_t(1) << 62;
+    huge.global_extents[1] = 8;
+    write_file(path, huge, data);
+    REQUIRE_THROWS(MappedCheckpoint<float, 2>(path));
+
+    CheckpointHeader far = header;
+    far.data_offset = ~uint64_t(0) - 8;
+    write_file(path, far, data);
+    REQUIRE_THROWS(MappedCheckpoint<float, 2>(path));
+
+    CHECK(header.data_fits(CheckpointHeader::size_in_file + 48));
+    CHECK(!header.data_fits(CheckpointHeader::size_in_file + 47));
+    CHECK(!huge.data_fits(~uint64_t(0)));
+
+    std::remove(path.c_str());
+
+}
@@ -1,8 +1,37 @@
 #include "catch.hpp"
 
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+#include "mpi_buffer_pool.hpp"
+#include "mpi_channel.hpp"
 #include "mpi_communicator.hpp"
+#include "mpi_communicator_pool.hpp"
+#include "mpi_compressed_transport.hpp"
+#include "mpi_distributed_array.hpp"
+#include "mpi_distributed_hash_map.hpp"
+#include "mpi_global_counter.hpp"
+#include "mpi_graph_communicator.hpp"
+#include "mpi_load_balancer.hpp"
+#include "mpi_array_io.hpp"
 #include "mpi_cart_communicator.hpp"
+#include "mpi_checkpoint.hpp"
+#include "mpi_checkpoint_writer.hpp"
 #include "mpi_native_datatypes.hpp"
+#include "mpi_node_aggregator.hpp"
+#include "mpi_particle_migrator.hpp"
+#include "mpi_pencil_transpose.hpp"
+#include "mpi_redistribution.hpp"
+#include "mpi_request_scheduler.hpp"
+#include "mpi_sample_sort.hpp"
+#include "mpi_scan.hpp"
+#include "mpi_window.hpp"
+#include "mpi_work_stealing_queue.hpp"
+#include "mpi_sfc_partitioner.hpp"
 
 
 
@@ -14,6 +43,93 @@ TEST_CASE("Communicator tests"){
 
 }
 
+TEST_CASE("Communicator ownership"){
+
+    using namespace MpiWrapper;
+
+    Communicator world;
+
+    auto factory = [&](){ return world.dup(); };
+
+    Communicator c1 = factory();
+    CHECK(c1.get_handle() != world.get_handle());
+    CHECK(c1.size() == world.size());
+
+    //copies share the handle and keep it alive
+    Communicator c2 = c1;
+    CHECK(c2.get_handle() == c1.get_handle());
+    {
+        Communicator c3(c1);
+        Communicator c4 = world;
+        c4 = c3;
+        CHECK(c4.get_handle() == c1.get_handle());
+    }
+    c1 = Communicator();
+    CHECK(c1.get_handle() == world.get_handle());
+    REQUIRE_NOTHROW(c2.get_rank());
+
+    //moves transfer the ownership
+    Communicator c5(std::move(c2));
+    CHECK(c2.is_null());
+    CHECK(!c5.is_null());
+    REQUIRE_NOTHROW(c5.get_rank());
+
+    Communicator c6;
+    c6 = std::move(c5);
+    CHECK(c5.is_null());
+    REQUIRE_NOTHROW(c6.get_rank());
+
+    //borrowed handles are never freed
+    MPI_Comm raw = Mpi::comm_dup(world.get_handle());
+    {
+        auto view = Communicator::borrow(raw);
+        CHECK(view.get_handle() == raw);
+    }
+    REQUIRE_NOTHROW(Mpi::get_rank(raw));
+    Mpi::comm_free(raw);
+
+}
+
+TEST_CASE("Communicator factories"){
+
+    using namespace MpiWrapper;
+
+    Communicator world;
+    int rank = world.get_rank();
+    int size = world.size();
+
+    //split to even and odd ranks
+    auto parity = world.split(rank % 2);
+    CHECK(parity.size() == (size + 1 - rank % 2) / 2);
+    CHECK(parity.get_rank() == rank / 2);
+
+    //reverse order by key
+    auto reversed = world.split(0, size - rank);
+    CHECK(reversed.get_rank() == size - 1 - rank);
+
+    auto none = world.split(MPI_UNDEFINED);
+    CHECK(none.is_null());
+
+    auto node = world.split_type();
+    CHECK(node.size() >= 1);
+    CHECK(node.size() <= size);
+
+    //first half of the ranks
+    std::vector<int> ranks;
+    for (int i = 0; i < (size + 1) / 2; ++i) { ranks.push_back(i); }
+    bool member = rank < (size + 1) / 2;
+
+    auto half = world.create(ranks);
+    CHECK(half.is_null() == !member);
+
+    if (member){
+        auto half2 = world.create_group(ranks, 3);
+        CHECK(half2.size() == int(ranks.size()));
+        CHECK(half2.get_rank() == rank);
+    }
+
+}
+
 TEST_CASE ("CartCommunicator constructors"){
 
     using namespace MpiWrapper;
@@ -122,6 +238,1469 @@ TEST_CASE("CartCommunicator::shift()"){
 
 
 
+TEST_CASE("CartCommunicator::sub()"){
+
+    using namespace MpiWrapper;
+
+    size_t world_size = static_cast<size_t>(Mpi::world_size());
+    size_t n0 = world_size % 2 == 0 ? 2 : 1;
+
+    std::array<size_t, 3> dims{n0, world_size / n0, 1};
+    std::array<size_t, 3> periods{1, 0, 1};
+
+    CartCommunicator<3> comm(dims, periods, 0);
+    auto coords = comm.get_coords();
+
+    //rows along x
+    auto row = comm.sub<1>({1, 0, 0});
+    CHECK(row.size() == int(n0));
+    CHECK(row.get_topology_dims()[0] == n0);
+    CHECK(row.get_periods()[0] == 1);
+    CHECK(row.get_coords()[0] == coords[0]);
+
+    //yz-planes
+    auto plane = comm.sub<2>({0, 1, 1});
+    CHECK(plane.size() == int(world_size / n0));
+    CHECK(plane.get_topology_dims() == std::array<size_t, 2>{world_size / n0, 1});
+    CHECK(plane.get_periods() == std::array<size_t, 2>{0, 1});
+    CHECK(plane.get_coords() == std::array<size_t, 2>{coords[1], coords[2]});
+
+    //reduction restricted to the row
+    int value = 1;
+    int sum = 0;
+    MPI_Allreduce(&value, &sum, 1, MPI_INT, MPI_SUM, row.get_handle());
+    CHECK(sum == int(n0));
+
+    REQUIRE_THROWS(comm.sub<2>({1, 0, 0}));
+
+}
+
+TEST_CASE("GraphCommunicator"){
+
+    using namespace MpiWrapper;
+
+    int rank = Mpi::get_world_rank();
+    int size = Mpi::world_size();
+    int right = (rank + 1) % size;
+    int left = (rank - 1 + size) % size;
+
+    //directed ring
+    GraphCommunicator ring({left}, {right}, 0);
+    REQUIRE(ring.get_sources() == std::vector<int>{left});
+    REQUIRE(ring.get_destinations() == std::vector<int>{right});
+    CHECK(ring.get_source_weights().empty());
+
+    std::vector<double> send{double(rank), double(rank)};
+    std::vector<double> recv(2, -1.0);
+    ring.halo_exchange(send.data(), {2}, MpiDatatype<double>(), recv.data(), {2});
+    CHECK(recv[0] == double(left));
+    CHECK(recv[1] == double(left));
+
+    //weighted, undirected ring with reordering allowed
+    GraphCommunicator wring({left, right}, {1, 2}, {left, right}, {1, 2}, 1);
+    REQUIRE(wring.get_sources().size() == 2);
+    CHECK(wring.get_source_weights() == std::vector<int>{1, 2});
+    CHECK(wring.get_destination_weights() == std::vector<int>{1, 2});
+
+    //mismatched weights are rejected before MPI reads them
+    using Weights = std::vector<int>;
+    REQUIRE_THROWS_AS(GraphCommunicator({left, right}, Weights{1}, {left, right}, {1, 2}),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(GraphCommunicator({left, right}, {1, 2}, {left, right}, Weights{1, 2, 3}),
+                      std::invalid_argument);
+
+    int me = wring.get_rank();
+    int wleft = wring.get_sources()[0];
+    int wright = wring.get_sources()[1];
+
+    //send one value to left and two to right (left and right are distinct only for size > 2)
+    if (size > 2){
+        std::vector<int> wsend{me, me, me};
+        std::vector<int> wrecv(3, -1);
+        wring.halo_exchange(wsend.data(), {1, 2}, MpiDatatype<int>(), wrecv.data(), {2, 1});
+        CHECK(wrecv[0] == wleft);
+        CHECK(wrecv[1] == wleft);
+        CHECK(wrecv[2] == wright);
+    }
+
+    //isolated processes
+    GraphCommunicator empty(std::vector<int>{}, std::vector<int>{}, 0);
+    CHECK(empty.get_sources().empty());
+    REQUIRE_NOTHROW(empty.halo_exchange(send.data(), {}, MpiDatatype<double>(), recv.data(), {}));
+
+}
+
+TEST_CASE("PencilTranspose"){
+
+    using namespace MpiWrapper;
+
+    size_t world_size = static_cast<size_t>(Mpi::world_size());
+    size_t p0 = world_size % 2 == 0 ? 2 : 1;
+
+    CartCommunicator<2> grid({p0, world_size / p0}, {0, 0}, 0);
+
+    //non-divisible extents
+    std::array<size_t, 3> global{5, 7, 3};
+    PencilTranspose<double> transpose(grid, global);
+
+    auto value = [](size_t i, size_t j, size_t k){ return double(i + 10 * j + 100 * k); };
+
+    auto fill = [&](Pencil p){
+        auto e = transpose.local_extents(p);
+        auto o = transpose.local_offsets(p);
+        std::vector<double> ret(transpose.local_size(p));
+        for (size_t k = 0; k < e[2]; ++k){
+        for (size_t j = 0; j < e[1]; ++j){
+        for (size_t i = 0; i < e[0]; ++i){
+            ret[i + e[0] * (j + e[1] * k)] = value(i + o[0], j + o[1], k + o[2]);
+        }}}
+        return ret;
+    };
+
+    CHECK(transpose.local_extents(Pencil::X)[0] == 5);
+    CHECK(transpose.local_extents(Pencil::Y)[1] == 7);
+    CHECK(transpose.local_extents(Pencil::Z)[2] == 3);
+
+    size_t total = transpose.local_size(Pencil::X);
+    MPI_Allreduce(MPI_IN_PLACE, &total, 1, MPI_UNSIGNED_LONG, MPI_SUM, MPI_COMM_WORLD);
+    CHECK(total == 5 * 7 * 3);
+
+    auto x = fill(Pencil::X);
+    std::vector<double> y(transpose.local_size(Pencil::Y), -1.0);
+    std::vector<double> z(transpose.local_size(Pencil::Z), -1.0);
+
+    transpose.x_to_y(x.data(), y.data());
+    CHECK(y == fill(Pencil::Y));
+
+    transpose.y_to_z(y.data(), z.data());
+    CHECK(z == fill(Pencil::Z));
+
+    std::fill(y.begin(), y.end(), -1.0);
+    transpose.z_to_y(z.data(), y.data());
+    CHECK(y == fill(Pencil::Y));
+
+    std::vector<double> x2(x.size(), -1.0);
+    transpose.y_to_x(y.data(), x2.data());
+    CHECK(x2 == x);
+
+    REQUIRE_THROWS(transpose.x_to_y(x.data(), x.data()));
+
+    //complex data
+    PencilTranspose<std::complex<double>> ctranspose(grid, {4, 4, 4});
+    std::vector<std::complex<double>> cx(ctranspose.local_size(Pencil::X), {1.0, 2.0});
+    std::vector<std::complex<double>> cy(ctranspose.local_size(Pencil::Y));
+    ctranspose.x_to_y(cx.data(), cy.data());
+    for (auto c : cy){
+        CHECK(c == std::complex<double>(1.0, 2.0));
+    }
+
+}
+
+TEST_CASE("DistributedArray"){
+
+    using namespace MpiWrapper;
+
+    size_t world_size = static_cast<size_t>(Mpi::world_size());
+    size_t n0 = world_size % 2 == 0 ? 2 : 1;
+
+    //periodic in x, non-periodic in y
+    CartCommunicator<2> comm({n0, world_size / n0}, {1, 0}, 0);
+    std::array<size_t, 2> global{7, 2 * world_size + 1};
+
+    DistributedArray<double, 2> arr(comm, global, 2);
+
+    auto ext = arr.local_extents();
+    auto off = arr.local_offsets();
+
+    //aligned storage and padded rows
+    CHECK(reinterpret_cast<std::uintptr_t>(arr.data()) % Utils::cache_line_size == 0);
+    CHECK(arr.strides()[0] * sizeof(double) % Utils::cache_line_size == 0);
+    CHECK(reinterpret_cast<std::uintptr_t>(&arr({0, 0})) % Utils::cache_line_size == 0);
+    CHECK(reinterpret_cast<std::uintptr_t>(&arr({1, 0})) % Utils::cache_line_size == 0);
+
+    size_t total = arr.local_size();
+    MPI_Allreduce(MPI_IN_PLACE, &total, 1, MPI_UNSIGNED_LONG, MPI_SUM, MPI_COMM_WORLD);
+    CHECK(total == global[0] * global[1]);
+
+    CHECK(arr.local_to_global({0, 0}) == off);
+    CHECK(arr.global_to_local(off) == std::array<int, 2>{0, 0});
+
+    auto value = [](size_t i, size_t j){ return double(100 * i + j); };
+
+    int g = 2;
+    for (int i = -g; i < int(ext[0]) + g; ++i){
+    for (int j = -g; j < int(ext[1]) + g; ++j){
+        bool interior = i >= 0 && j >= 0 && i < int(ext[0]) && j < int(ext[1]);
+        auto gi = arr.local_to_global({i, j});
+        arr({i, j}) = interior ? value(gi[0], gi[1]) : -1.0;
+    }}
+
+    arr.exchange_ghosts();
+
+    for (int i = -g; i < int(ext[0]) + g; ++i){
+    for (int j = -g; j < int(ext[1]) + g; ++j){
+        int gi = int(off[0]) + i;
+        int gj = int(off[1]) + j;
+        gi = (gi + int(global[0])) % int(global[0]);
+        if (gj < 0 || gj >= int(global[1])){
+            CHECK(arr({i, j}) == -1.0);
+        } else {
+            CHECK(arr({i, j}) == value(size_t(gi), size_t(gj)));
+        }
+    }}
+
+    //gather and scatter roundtrip
+    std::vector<double> all(global[0] * global[1], -1.0);
+    arr.gather_to_root(all.data());
+    if (comm.get_rank() == 0){
+        for (size_t i = 0; i < global[0]; ++i){
+        for (size_t j = 0; j < global[1]; ++j){
+            CHECK(all[i * global[1] + j] == value(i, j));
+        }}
+        for (auto& a : all) { a *= 2.0; }
+    }
+
+    arr.scatter_from_root(all.data());
+    for (int i = 0; i < int(ext[0]); ++i){
+    for (int j = 0; j < int(ext[1]); ++j){
+        auto gi = arr.local_to_global({i, j});
+        CHECK(arr({i, j}) == 2.0 * value(gi[0], gi[1]));
+    }}
+
+    //ghost width larger than the block
+    REQUIRE_THROWS(DistributedArray<double, 2>(comm, {1, 1}, 2));
+
+}
+
+TEST_CASE("Pack engine"){
+
+    using namespace MpiWrapper;
+
+    //same bytes as MPI_Pack of the subarray type, narrow, wide and streamed rows
+    std::array<size_t, 3> storage{6, 700, 320};
+    std::vector<double> base(storage[0] * storage[1] * storage[2]);
+    for (size_t i = 0; i < base.size(); ++i) { base[i] = double(i); }
+
+    std::array<std::array<size_t, 3>, 3> subsizes{{{2, 5, 3}, {3, 4, 37}, {2, 640, 300}}};
+    std::array<size_t, 3> starts{1, 30, 7};
+    for (const auto& sub : subsizes){
+        Utils::SubarrayLayout<3> layout;
+        layout.extents = sub;
+        layout.strides = {storage[1] * storage[2], storage[2], 1};
+        layout.offset = starts[0] * layout.strides[0] + starts[1] * layout.strides[1] + starts[2];
+
+        auto type = DerivedDatatype::subarray(storage, sub, starts, MpiDatatype<double>());
+        std::vector<double> expected(layout.size()), packed(layout.size());
+        int position = 0;
+        MPI_Pack(base.data(), 1, ~type, expected.data(), int(expected.size() * sizeof(double)),
+                 &position, MPI_COMM_WORLD);
+        Utils::pack(base.data(), layout, packed.data());
+        CHECK(packed == expected);
+
+        std::vector<double> target(base.size(), -1.0), reference(base.size(), -1.0);
+        Utils::unpack(packed.data(), layout, target.data());
+        position = 0;
+        MPI_Unpack(expected.data(), int(expected.size() * sizeof(double)), &position,
+                   reference.data(), 1, ~type, MPI_COMM_WORLD);
+        CHECK(target == reference);
+    }
+
+    //both halo paths give the same ghosts
+    size_t world_size = static_cast<size_t>(Mpi::world_size());
+    size_t n0 = world_size % 2 == 0 ? 2 : 1;
+    CartCommunicator<3> comm({n0, 1, world_size / n0}, {1, 0, 1}, 0);
+    std::array<size_t, 3> global{6, 5, 4 * world_size};
+
+    for (size_t g : {size_t(1), size_t(2)}){
+        DistributedArray<int, 3> by_type(comm, global, g), by_engine(comm, global, g);
+        by_engine.set_halo_packing(HaloPacking::Engine);
+        CHECK(by_type.halo_packing() == HaloPacking::Datatype);
+        CHECK(by_engine.halo_packing() == HaloPacking::Engine);
+
+        auto ext = by_type.local_extents();
+        for (int i = 0; i < int(ext[0]); ++i){
+        for (int j = 0; j < int(ext[1]); ++j){
+        for (int k = 0; k < int(ext[2]); ++k){
+            auto gi = by_type.local_to_global({i, j, k});
+            int v = int(10000 * gi[0] + 100 * gi[1] + gi[2]);
+            by_type({i, j, k}) = v;
+            by_engine({i, j, k}) = v;
+        }}}
+        by_type.exchange_ghosts();
+        by_engine.exchange_ghosts();
+
+        std::vector<int> a(by_type.data(), by_type.data() + by_type.storage_size());
+        std::vector<int> b(by_engine.data(), by_engine.data() + by_engine.storage_size());
+        CHECK(a == b);
+        //periodic ghost in z was filled
+        auto off = by_engine.local_offsets();
+        auto gz = (off[2] + global[2] - 1) % global[2];
+        CHECK(by_engine({0, 0, -1}) == int(10000 * off[0] + gz));
+    }
+
+}
+
+TEST_CASE("Redistribution"){
+
+    using namespace MpiWrapper;
+
+    size_t world_size = static_cast<size_t>(Mpi::world_size());
+    size_t n0 = world_size % 2 == 0 ? 2 : 1;
+
+    std::array<size_t, 2> global{9, 5};
+    auto value = [](std::array<size_t, 2> gi){ return int(100 * gi[0] + gi[1]); };
+
+    //slabs in y with ghosts to a 2D split without ghosts
+    CartCommunicator<2> slabs({1, world_size}, {0, 0}, 0);
+    CartCommunicator<2> blocks({n0, world_size / n0}, {0, 0}, 1);
+
+    DistributedArray<int, 2> src(slabs, global, 1);
+    DistributedArray<int, 2> dst(blocks, global, 0);
+
+    auto fill = [&](DistributedArray<int, 2>& arr, bool by_value){
+        auto ext = arr.local_extents();
+        for (int i = 0; i < int(ext[0]); ++i){
+        for (int j = 0; j < int(ext[1]); ++j){
+            arr({i, j}) = by_value ? value(arr.local_to_global({i, j})) : -1;
+        }}
+    };
+
+    auto check = [&](const DistributedArray<int, 2>& arr){
+        auto ext = arr.local_extents();
+        for (int i = 0; i < int(ext[0]); ++i){
+        for (int j = 0; j < int(ext[1]); ++j){
+            CHECK(arr({i, j}) == value(arr.local_to_global({i, j})));
+        }}
+    };
+
+    fill(src, true);
+    fill(dst, false);
+
+    Redistribution<int, 2> plan(src, dst);
+    plan.execute(src, dst);
+    check(dst);
+
+    //the processes only talk to the overlapping blocks
+    CHECK(plan.send_count() <= n0);
+
+    //and back
+    fill(src, false);
+    Redistribution<int, 2> back(dst, src);
+    back.execute(dst, src);
+    check(src);
+
+    REQUIRE_THROWS(Redistribution<int, 2>(src, DistributedArray<int, 2>(blocks, {9, 4})));
+
+}
+
+TEST_CASE("LoadBalancer"){
+
+    using namespace MpiWrapper;
+
+    size_t world_size = static_cast<size_t>(Mpi::world_size());
+
+    CartCommunicator<2> comm({world_size, 1}, {0, 0}, 0);
+    std::array<size_t, 2> global{8 * world_size, 4};
+    DistributedArray<int, 2> arr(comm, global, 1);
+
+    auto value = [](std::array<size_t, 2> gi){ return int(100 * gi[0] + gi[1]); };
+    auto ext = arr.local_extents();
+    for (int i = 0; i < int(ext[0]); ++i){
+    for (int j = 0; j < int(ext[1]); ++j){
+        arr({i, j}) = value(arr.local_to_global({i, j}));
+    }}
+
+    //the first block is ten times as expensive per point
+    auto cost_of = [&](){
+        double density = arr.local_offsets()[0] == 0 ? 10.0 : 1.0;
+        return density * double(arr.local_size());
+    };
+
+    LoadBalancer balancer(1.2);
+    CHECK(LoadBalancer::imbalance(comm, 1.0) == Approx(1.0));
+
+    double before = LoadBalancer::imbalance(comm, cost_of());
+    bool changed = balancer.rebalance(arr, cost_of());
+
+    if (world_size == 1){
+        CHECK(!changed);
+    }
+    else {
+        CHECK(changed);
+        CHECK(arr.bounds(0).front() == 0);
+        CHECK(arr.bounds(0).back() == global[0]);
+        CHECK(arr.bounds(0)[1] < 8);
+        CHECK(arr.global_extents() == global);
+    }
+
+    //the data follows the new partition
+    ext = arr.local_extents();
+    for (int i = 0; i < int(ext[0]); ++i){
+    for (int j = 0; j < int(ext[1]); ++j){
+        CHECK(arr({i, j}) == value(arr.local_to_global({i, j})));
+    }}
+
+    //with the block 0 cost density the new partition is better balanced
+    double cost = 0.0;
+    for (size_t i = arr.local_offsets()[0]; i < arr.local_offsets()[0] + ext[0]; ++i){
+        cost += (i < 8 ? 10.0 : 1.0) * double(ext[1]);
+    }
+    CHECK(LoadBalancer::imbalance(comm, cost) <= before);
+
+    //a balanced load does not trigger
+    CHECK(!balancer.rebalance(arr, 1.0));
+
+    //explicit partition
+    std::array<std::vector<size_t>, 2> bounds;
+    bounds[0].push_back(0);
+    for (size_t r = 0; r < world_size; ++r) { bounds[0].push_back(bounds[0].back() + r + 1); }
+    bounds[1] = {0, 3};
+    DistributedArray<int, 2> custom(comm, bounds);
+    CHECK(custom.local_extents()[0] == comm.get_coords()[0] + 1);
+    CHECK(custom.global_extents()[1] == 3);
+
+    //a direction with fewer points than processes keeps its partition
+    std::array<size_t, 2> thin_global{(world_size + 1) / 2, 8};
+    DistributedArray<int, 2> thin(comm, thin_global, 0);
+    double thin_cost = comm.get_coords()[0] == 0 ? 10.0 : 1.0;
+    auto thin_bounds = balancer.compute_bounds(thin, thin_cost);
+    CHECK(thin_bounds[0] == thin.bounds(0));
+    CHECK(thin_bounds[1] == std::vector<size_t>{0, 8});
+    CHECK(!balancer.rebalance(thin, thin_cost));
+
+}
+
+TEST_CASE("ParticleMigrator"){
+
+    using namespace MpiWrapper;
+
+    int world_size = Communicator().size();
+    size_t n0 = world_size % 2 == 0 ? 2 : 1;
+
+    using Migrator = ParticleMigrator<2>;
+    CHECK(Migrator::n_directions == 9);
+    CHECK(Migrator::direction(0) == std::array<int, 2>{-1, -1});
+    CHECK(Migrator::direction(Migrator::centre) == std::array<int, 2>{0, 0});
+    CHECK(Migrator::direction(5) == std::array<int, 2>{0, 1});
+
+    auto run = [&](std::array<size_t, 2> periods){
+
+        CartCommunicator<2> comm({n0, size_t(world_size) / n0}, periods, 0);
+        auto dims   = comm.get_topology_dims();
+        auto coords = comm.get_coords();
+
+        Migrator migrator(comm, {0.0, 0.0}, {1.0, 1.0});
+
+        //one particle per direction, moved from the centre of the block by 3/4 of its size
+        std::array<double, 2> h, centre;
+        for (size_t d = 0; d < 2; ++d){
+            h[d]      = 1.0 / double(dims[d]);
+            centre[d] = (double(coords[d]) + 0.5) * h[d];
+        }
+
+        std::array<std::vector<double>, 2> x;
+        std::vector<int> id;
+        std::vector<float> mass;
+        for (size_t k = 0; k < Migrator::n_directions; ++k){
+            auto dir = Migrator::direction(k);
+            for (size_t d = 0; d < 2; ++d){
+                x[d].push_back(centre[d] + 0.75 * h[d] * dir[d]);
+            }
+            id.push_back(comm.get_rank() * 9 + int(k));
+            mass.push_back(float(k));
+        }
+        auto capacity = x[0].capacity();
+
+        auto& dir = migrator.classify(x);
+        for (size_t k = 0; k < Migrator::n_directions; ++k) { CHECK(dir[k] == k); }
+
+        size_t sent = migrator.migrate(x, id, mass);
+        CHECK(sent == Migrator::n_directions - 1);
+
+        REQUIRE(x[1].size() == x[0].size());
+        REQUIRE(id.size() == x[0].size());
+        REQUIRE(mass.size() == x[0].size());
+
+        //the staying particle is compacted in place to the front
+        CHECK(id[0] == comm.get_rank() * 9 + int(Migrator::centre));
+        if (x[0].size() <= Migrator::n_directions) { CHECK(x[0].capacity() == capacity); }
+
+        for (size_t i = 0; i < x[0].size(); ++i){
+            for (size_t d = 0; d < 2; ++d){
+                CHECK(x[d][i] >= double(coords[d]) * h[d]);
+                CHECK(x[d][i] < double(coords[d] + 1) * h[d]);
+            }
+            CHECK(mass[i] == float(id[i] % 9));
+        }
+
+        long local = long(x[0].size());
+        long total = 0;
+        MPI_Allreduce(&local, &total, 1, MPI_LONG, MPI_SUM, comm.get_handle());
+        return total;
+    };
+
+    //every particle is received by some process
+    CHECK(run({1, 1}) == 9 * world_size);
+
+    //particles leaving the global domain are removed
+    long expected = 0;
+    for (int i = 0; i < int(n0); ++i){
+    for (int j = 0; j < world_size / int(n0); ++j){
+        for (int a = -1; a <= 1; ++a){
+        for (int b = -1; b <= 1; ++b){
+            bool inside = i + a >= 0 && i + a < int(n0) && j + b >= 0 && j + b < world_size / int(n0);
+            expected += inside ? 1 : 0;
+        }}
+    }}
+    CHECK(run({0, 0}) == expected);
+
+}
+
+TEST_CASE("sample_sort"){
+
+    using namespace MpiWrapper;
+
+    Communicator comm;
+    int rank = comm.get_rank();
+    int size = comm.size();
+
+    auto key_of = [](long id) { return (id * 2654435761L) % 1000003L; };
+
+    long n     = 200 + 37 * rank;
+    long first = 0;
+    for (int r = 0; r < rank; ++r) { first += 200 + 37 * r; }
+
+    std::vector<long> keys, ids;
+    for (long i = 0; i < n; ++i){
+        keys.push_back(key_of(first + i));
+        ids.push_back(first + i);
+    }
+
+    //checks the local order and the order across the ranks
+    auto check_sorted = [&](const std::vector<long>& v, auto comp){
+        CHECK(std::is_sorted(v.begin(), v.end(), comp));
+        std::vector<long> ends{v.empty() ? 0 : v.front(), v.empty() ? 0 : v.back()};
+        std::vector<long> all_ends(2 * size_t(size));
+        std::vector<int> counts(static_cast<size_t>(size));
+        int local = int(v.size());
+        MPI_Allgather(ends.data(), 2, MPI_LONG, all_ends.data(), 2, MPI_LONG, comm.get_handle());
+        MPI_Allgather(&local, 1, MPI_INT, counts.data(), 1, MPI_INT, comm.get_handle());
+        long last = 0;
+        bool have = false;
+        for (size_t p = 0; p < size_t(size); ++p){
+            if (counts[p] == 0) { continue; }
+            if (have) { CHECK(!comp(all_ends[2 * p], last)); }
+            last = all_ends[2 * p + 1];
+            have = true;
+        }
+        long total = 0;
+        long count = long(v.size());
+        MPI_Allreduce(&count, &total, 1, MPI_LONG, MPI_SUM, comm.get_handle());
+        return total;
+    };
+
+    long expected = first + n;
+    MPI_Bcast(&expected, 1, MPI_LONG, size - 1, comm.get_handle());
+
+    SECTION("keys"){
+        auto descending = keys;
+        double imbalance = sample_sort(comm, keys);
+        CHECK(imbalance >= 1.0);
+        CHECK(imbalance < 2.0);
+        CHECK(check_sorted(keys, std::less<long>()) == expected);
+
+        sample_sort(comm, descending, std::greater<long>());
+        CHECK(check_sorted(descending, std::greater<long>()) == expected);
+    }
+
+    SECTION("key-value"){
+        double imbalance = sample_sort(comm, keys, ids);
+        CHECK(imbalance >= 1.0);
+        CHECK(imbalance < 2.0);
+        CHECK(check_sorted(keys, std::less<long>()) == expected);
+        REQUIRE(ids.size() == keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) { CHECK(keys[i] == key_of(ids[i])); }
+    }
+
+    SECTION("empty ranks"){
+        if (rank % 2 == 1) { keys.clear(); }
+        long local = long(keys.size());
+        long total = 0;
+        MPI_Allreduce(&local, &total, 1, MPI_LONG, MPI_SUM, comm.get_handle());
+        sample_sort(comm, keys);
+        CHECK(check_sorted(keys, std::less<long>()) == total);
+    }
+
+}
+
+TEST_CASE("Distributed scans"){
+
+    using namespace MpiWrapper;
+
+    Communicator comm;
+    int rank = comm.get_rank();
+    int size = comm.size();
+
+    //the global sequence is known everywhere, rank 1 holds no elements
+    auto local_n = [](int r) { return r == 1 ? size_t(0) : size_t(4 + r); };
+    auto value   = [](size_t g) { return long(g % 5 + 1); };
+    auto head    = [](size_t g) { return uint8_t(g % 7 == 3); };
+
+    size_t first = 0;
+    for (int r = 0; r < rank; ++r) { first += local_n(r); }
+    size_t n = local_n(rank);
+    size_t global_n = 0;
+    for (int r = 0; r < size; ++r) { global_n += local_n(r); }
+
+    std::vector<long> in(n), out(n);
+    std::vector<uint8_t> heads(n);
+    for (size_t i = 0; i < n; ++i){
+        in[i]    = value(first + i);
+        heads[i] = head(first + i);
+    }
+
+    long total = 0;
+    std::vector<long> incl(global_n), excl(global_n), seg_incl(global_n), seg_excl(global_n);
+    long seg = 0;
+    for (size_t g = 0; g < global_n; ++g){
+        excl[g] = total;
+        total += value(g);
+        incl[g] = total;
+        if (head(g)) { seg = 0; }
+        seg_excl[g] = seg;
+        seg += value(g);
+        seg_incl[g] = seg;
+    }
+
+    CHECK(inclusive_scan(comm, in.data(), out.data(), n) == total);
+    for (size_t i = 0; i < n; ++i) { CHECK(out[i] == incl[first + i]); }
+
+    CHECK(exclusive_scan(comm, in.data(), out.data(), n) == total);
+    for (size_t i = 0; i < n; ++i) { CHECK(out[i] == excl[first + i]); }
+
+    segmented_inclusive_scan(comm, in.data(), heads.data(), out.data(), n);
+    for (size_t i = 0; i < n; ++i) { CHECK(out[i] == seg_incl[first + i]); }
+
+    //in place
+    out = in;
+    segmented_exclusive_scan(comm, out.data(), heads.data(), out.data(), n);
+    for (size_t i = 0; i < n; ++i) { CHECK(out[i] == seg_excl[first + i]); }
+
+    std::vector<double> ones(n, 1.0);
+    CHECK(exclusive_scan(comm, ones.data(), ones.data(), n) == double(global_n));
+    for (size_t i = 0; i < n; ++i) { CHECK(ones[i] == double(first + i)); }
+
+}
+
+TEST_CASE("Window"){
+
+    using namespace MpiWrapper;
+
+    Communicator comm;
+    int rank  = comm.get_rank();
+    int size  = comm.size();
+    int right = (rank + 1) % size;
+
+    Window<long> win(comm, 4);
+    REQUIRE(win.size() == 4);
+    std::fill_n(win.data(), 4, 0L);
+    MPI_Barrier(comm.get_handle());
+
+    //the epoch checker is active in the debug build of the tests
+    long value = rank;
+    REQUIRE_THROWS(win.put(&value, 1, right, 0));
+    REQUIRE_THROWS(win.flush_all());
+    REQUIRE_THROWS(win.unlock_all());
+
+    win.lock_all();
+    REQUIRE_THROWS(win.lock_all());
+    REQUIRE_THROWS(win.lock(right));
+    win.put(&value, 1, right, 0);
+    long one = 1;
+    for (int r = 0; r < size; ++r) { win.accumulate(&one, 1, r, 1); }
+    win.flush_all();
+    win.unlock_all();
+    MPI_Barrier(comm.get_handle());
+
+    std::array<long, 2> got{};
+    win.lock(rank);
+    win.get(got.data(), 2, rank, 0);
+    win.unlock(rank);
+    REQUIRE_THROWS(win.unlock(rank));
+    CHECK(got[0] == (rank + size - 1) % size);
+    CHECK(got[1] == size);
+
+    //exclusive epochs serialize the read-modify-write on rank 0
+    win.lock(0, true);
+    long counter = 0;
+    win.get(&counter, 1, 0, 2);
+    win.flush(0);
+    counter += 1;
+    win.put(&counter, 1, 0, 2);
+    win.unlock(0);
+    MPI_Barrier(comm.get_handle());
+
+    win.lock_all();
+    win.get(&counter, 1, 0, 2);
+    win.flush(0);
+    win.unlock_all();
+    CHECK(counter == size);
+
+    Window<long> moved(std::move(win));
+    CHECK(moved.size() == 4);
+    CHECK(win.get_handle() == MPI_WIN_NULL);
+
+}
+
+TEST_CASE("DistributedHashMap"){
+
+    using namespace MpiWrapper;
+
+    Communicator comm;
+    int rank = comm.get_rank();
+    int size = comm.size();
+
+    //small buckets and a tight capacity force collisions and probing across buckets
+    const long n_local = 50;
+    DistributedHashMap<long, int> map(comm, size_t(n_local) + 14, 16, 2);
+
+    std::vector<long> keys;
+    std::vector<int> owners;
+    for (long i = 0; i < n_local; ++i){
+        keys.push_back(7 * (rank * n_local + i));
+        owners.push_back(rank);
+    }
+    CHECK(map.insert(keys, owners).empty());
+    map.sync();
+
+    //every process looks up all the keys and a missing one
+    std::vector<long> queries;
+    for (long g = 0; g < size * n_local; ++g) { queries.push_back(7 * g); }
+    queries.push_back(3);
+    auto found = map.find(queries);
+    REQUIRE(found.size() == queries.size());
+    for (size_t g = 0; g + 1 < queries.size(); ++g){
+        REQUIRE(found[g].has_value());
+        CHECK(*found[g] == int(g / size_t(n_local)));
+    }
+    CHECK(!found.back().has_value());
+    CHECK(map.cache_size() <= 16);
+
+    //the cache answers repeated lookups
+    auto hot = map.find(queries[0]);
+    REQUIRE(hot.has_value());
+    CHECK(*hot == 0);
+    CHECK(map.cache_size() >= 1);
+
+    //concurrent inserts of the same key end in one slot, the value of one writer wins whole
+    const int pattern = 0x01010101;
+    map.insert(-1, rank * pattern);
+    map.sync();
+    map.clear_cache();
+    auto shared = map.find(-1);
+    REQUIRE(shared.has_value());
+    CHECK(*shared % pattern == 0);
+    CHECK(*shared / pattern >= 0);
+    CHECK(*shared / pattern < size);
+
+    REQUIRE_THROWS(map.insert(DistributedHashMap<long, int>::empty_key, 0));
+
+    //an overfilled map reports the keys it could not take and stays usable
+    DistributedHashMap<long, int> small(comm, 4, 0, 2);
+    std::vector<long> many;
+    for (long i = 0; i < 6 * size; ++i) { many.push_back(1000 * rank + i); }
+    auto failed = small.insert(many, std::vector<int>(many.size(), rank));
+    small.sync();
+    long n_failed = long(failed.size()), total_failed = 0;
+    MPI_Allreduce(&n_failed, &total_failed, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+    CHECK(total_failed >= long(6 * size * size - 4 * size));
+
+    auto lookup = small.find(many);
+    for (size_t i = 0; i < many.size(); ++i){
+        bool dropped = std::find(failed.begin(), failed.end(), many[i]) != failed.end();
+        CHECK(lookup[i].has_value() == !dropped);
+    }
+    //existing keys can still be updated
+    if (lookup[0].has_value()) { CHECK(small.insert(many[0], -1)); }
+    small.sync();
+
+}
+
+TEST_CASE("GlobalCounter"){
+
+    using namespace MpiWrapper;
+
+    Communicator comm;
+    int size = comm.size();
+
+    GlobalCounter counter(comm, 10, size - 1);
+    CHECK(counter.root() == size - 1);
+
+    int64_t previous = counter.fetch_add(2);
+    CHECK(previous >= 10);
+    CHECK(previous < 10 + 2 * size);
+    MPI_Barrier(comm.get_handle());
+    CHECK(counter.load() == 10 + 2 * size);
+
+    //dynamic loop, every index is processed exactly once
+    GlobalCounter loop(comm);
+    const int64_t n = 1000;
+    std::vector<int> hits(n, 0);
+    int64_t begin, end;
+    while (loop.next_chunk(7, n, begin, end)){
+        for (int64_t i = begin; i < end; ++i) { hits[size_t(i)] += 1; }
+    }
+    MPI_Allreduce(MPI_IN_PLACE, hits.data(), int(n), MPI_INT, MPI_SUM, comm.get_handle());
+    CHECK(std::all_of(hits.begin(), hits.end(), [](int h) { return h == 1; }));
+
+}
+
+TEST_CASE("WorkStealingQueue"){
+
+    using namespace MpiWrapper;
+
+    Communicator comm;
+    int rank = comm.get_rank();
+
+    struct Task {
+        int depth;
+        int value;
+    };
+
+    WorkStealingQueue<Task> queue(comm, 256);
+
+    //all the work starts on rank 0, every task spawns two children until depth 6
+    if (rank == 0) { queue.push(Task{0, 1}); }
+
+    long processed = 0;
+    long sum = 0;
+    queue.run([&](const Task& t){
+        ++processed;
+        sum += t.value;
+        if (t.depth < 6) {
+            queue.push(std::vector<Task>{{t.depth + 1, t.value}, {t.depth + 1, t.value}});
+        }
+    });
+
+    long total = 0, total_sum = 0;
+    MPI_Allreduce(&processed, &total, 1, MPI_LONG, MPI_SUM, comm.get_handle());
+    MPI_Allreduce(&sum, &total_sum, 1, MPI_LONG, MPI_SUM, comm.get_handle());
+    CHECK(total == 127);
+    CHECK(total_sum == 127);
+    CHECK(queue.local_size() == 0);
+
+    //a second round reuses the queue
+    for (int i = 0; i < 10; ++i) { queue.push(Task{6, i}); }
+    processed = 0;
+    queue.run([&](const Task&){ ++processed; });
+    MPI_Allreduce(&processed, &total, 1, MPI_LONG, MPI_SUM, comm.get_handle());
+    CHECK(total == 10 * comm.size());
+
+    WorkStealingQueue<Task> small(comm, 2);
+    REQUIRE_THROWS(small.push(std::vector<Task>(3, Task{0, 0})));
+
+}
+
+TEST_CASE("Array I/O"){
+
+    using namespace MpiWrapper;
+
+    size_t world_size = static_cast<size_t>(Mpi::world_size());
+    size_t n0 = world_size % 2 == 0 ? 2 : 1;
+
+    CartCommunicator<2> blocks({n0, world_size / n0}, {0, 0}, 0);
+    CartCommunicator<2> slabs({1, world_size}, {0, 0}, 0);
+    std::array<size_t, 2> global{5, 3 * world_size + 2};
+
+    auto value = [](size_t i, size_t j) { return double(1000 * i + j); };
+
+    DistributedArray<double, 2> out(blocks, global, 1);
+    auto ext = out.local_extents();
+    for (int i = 0; i < int(ext[0]); ++i){
+    for (int j = 0; j < int(ext[1]); ++j){
+        auto g = out.local_to_global({i, j});
+        out({i, j}) = value(g[0], g[1]);
+    }}
+
+    const std::string path = "mpi_wrapper_array_io_test.bin";
+    const MPI_Offset header = 64;
+
+    FileHints hints;
+    hints.cb_nodes = 1;
+    hints.cb_buffer_size = 1 << 16;
+    hints.force_collective_buffering = true;
+
+    {
+        auto file = File::create(blocks, path, hints);
+        write_array(file, out, header);
+    }
+
+    //the file holds the global array in C order after the header
+    if (blocks.get_rank() == 0){
+        std::vector<double> raw(global[0] * global[1]);
+        std::FILE* f = std::fopen(path.c_str(), "rb");
+        REQUIRE(f != nullptr);
+        std::fseek(f, long(header), SEEK_SET);
+        CHECK(std::fread(raw.data(), sizeof(double), raw.size(), f) == raw.size());
+        std::fclose(f);
+        for (size_t i = 0; i < global[0]; ++i){
+        for (size_t j = 0; j < global[1]; ++j){
+            CHECK(raw[i * global[1] + j] == value(i, j));
+        }}
+    }
+
+    //restart on another decomposition
+    DistributedArray<double, 2> in(slabs, global, 1);
+    {
+        auto file = File::open(slabs, path);
+        CHECK(file.size() == header + MPI_Offset(global[0] * global[1] * sizeof(double)));
+        read_array(file, in, header);
+    }
+    auto in_ext = in.local_extents();
+    for (int i = 0; i < int(in_ext[0]); ++i){
+    for (int j = -1; j < int(in_ext[1]) + 1; ++j){
+        auto g = in.local_to_global({i, j});
+        if (g[1] < global[1]) { CHECK(in({i, j}) == value(g[0], g[1])); }
+    }}
+
+    //path overloads
+    write_array(path, in);
+    DistributedArray<double, 2> again(blocks, global);
+    read_array(path, again);
+    for (int i = 0; i < int(ext[0]); ++i){
+    for (int j = 0; j < int(ext[1]); ++j){
+        CHECK(again({i, j}) == out({i, j}));
+    }}
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (blocks.get_rank() == 0) { std::remove(path.c_str()); }
+
+    REQUIRE_THROWS(File::open(blocks, "mpi_wrapper_missing_file.bin"));
+
+}
+
+TEST_CASE("CheckpointWriter"){
+
+    using namespace MpiWrapper;
+
+    size_t world_size = static_cast<size_t>(Mpi::world_size());
+    CartCommunicator<2> slabs({world_size, 1}, {0, 0}, 0);
+    std::array<size_t, 2> global{2 * world_size + 1, 7};
+
+    DistributedArray<int, 2> arr(slabs, global, 1);
+    auto ext = arr.local_extents();
+    auto fill = [&](int step){
+        for (int i = 0; i < int(ext[0]); ++i){
+        for (int j = 0; j < int(ext[1]); ++j){
+            auto g = arr.local_to_global({i, j});
+            arr({i, j}) = int(100 * g[0] + g[1]) + 10000 * step;
+        }}
+    };
+
+    const std::vector<std::string> paths{"mpi_wrapper_checkpoint_0.bin",
+                                         "mpi_wrapper_checkpoint_1.bin"};
+
+    {
+        CheckpointWriter writer(1);
+
+        fill(0);
+        auto first = writer.write(arr, paths[0]);
+        CHECK(writer.in_flight() == 1);
+
+        //the array may be modified while the checkpoint is written
+        fill(1);
+        auto second = writer.write(arr, paths[1]);
+        CHECK(writer.in_flight() == 1);
+        CHECK(writer.test(first));
+
+        while (!writer.test(second)) {}
+        writer.wait(second);
+        CHECK(writer.in_flight() == 0);
+
+        //ids not returned by write() are rejected
+        CHECK(writer.test(first));
+        REQUIRE_THROWS_AS(writer.test(second + 1), std::out_of_range);
+        REQUIRE_THROWS_AS(writer.wait(second + 1), std::out_of_range);
+    }
+
+    for (int step = 0; step < 2; ++step){
+        DistributedArray<int, 2> in(slabs, global);
+        read_array(paths[size_t(step)], in);
+        for (int i = 0; i < int(ext[0]); ++i){
+        for (int j = 0; j < int(ext[1]); ++j){
+            auto g = in.local_to_global({i, j});
+            CHECK(in({i, j}) == int(100 * g[0] + g[1]) + 10000 * step);
+        }}
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (slabs.get_rank() == 0) {
+        for (const auto& path : paths) { std::remove(path.c_str()); }
+    }
+
+}
+
+TEST_CASE("NodeAggregator"){
+
+    using namespace MpiWrapper;
+
+    Communicator world;
+    size_t world_size = static_cast<size_t>(world.size());
+    size_t n0 = world_size % 2 == 0 ? 2 : 1;
+
+    CartCommunicator<3> blocks({n0, world_size / n0, 1}, {0, 0, 0}, 0);
+    std::array<size_t, 3> global{4, 2 * world_size + 1, 3};
+
+    DistributedArray<double, 3> arr(blocks, global, 1);
+    auto ext = arr.local_extents();
+    auto value = [](std::array<size_t, 3> g) { return double(10000 * g[0] + 100 * g[1] + g[2]); };
+    for (int i = 0; i < int(ext[0]); ++i){
+    for (int j = 0; j < int(ext[1]); ++j){
+    for (int k = 0; k < int(ext[2]); ++k){
+        arr({i, j, k}) = value(arr.local_to_global({i, j, k}));
+    }}}
+
+    const std::string path = "mpi_wrapper_node_aggregator_test.bin";
+    const MPI_Offset header = 16;
+
+    //small rounds split the rows and take several gathers and writes
+    for (int aggregators : {1, 2}){
+    for (size_t round : {size_t(INT_MAX), size_t(20)}){
+        NodeAggregator io(blocks, aggregators);
+        CHECK(io.n_aggregators() >= 1);
+        CHECK(io.n_aggregators() <= aggregators * int(world_size));
+        CHECK(io.is_aggregator() == (io.get_group().get_rank() == 0));
+        CHECK(io.round_bytes() == size_t(INT_MAX));
+
+        io.set_round_bytes(round);
+        io.write_array(path, arr, header);
+
+        //same layout as the collective write, readable on any decomposition
+        DistributedArray<double, 3> in(blocks, global);
+        {
+            auto file = File::open(blocks, path);
+            CHECK(file.size() == header + MPI_Offset(global[0] * global[1] * global[2] * 8));
+            read_array(file, in, header);
+        }
+        for (int i = 0; i < int(ext[0]); ++i){
+        for (int j = 0; j < int(ext[1]); ++j){
+        for (int k = 0; k < int(ext[2]); ++k){
+            CHECK(in({i, j, k}) == value(in.local_to_global({i, j, k})));
+        }}}
+    }}
+
+    //interleaved pieces of raw bytes
+    {
+        NodeAggregator io(world);
+        const int rank = world.get_rank();
+        const int n = int(world_size);
+        std::vector<int64_t> offsets{rank, n + rank};
+        std::vector<int> lengths{1, 1};
+        std::vector<unsigned char> data{uint8_t(rank), uint8_t(100 + rank)};
+        io.write(path, offsets, lengths, data.data());
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        if (rank == 0){
+            std::vector<unsigned char> raw(2 * world_size);
+            std::FILE* f = std::fopen(path.c_str(), "rb");
+            REQUIRE(f != nullptr);
+            CHECK(std::fread(raw.data(), 1, raw.size(), f) == raw.size());
+            CHECK(std::fgetc(f) == EOF);
+            std::fclose(f);
+            for (int r = 0; r < n; ++r){
+                CHECK(raw[size_t(r)] == r);
+                CHECK(raw[size_t(n + r)] == 100 + r);
+            }
+        }
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (blocks.get_rank() == 0) { std::remove(path.c_str()); }
+
+}
+
+TEST_CASE("Checkpoint format"){
+
+    using namespace MpiWrapper;
+
+    size_t world_size = static_cast<size_t>(Mpi::world_size());
+    size_t n0 = world_size % 2 == 0 ? 2 : 1;
+
+    CartCommunicator<2> blocks({n0, world_size / n0}, {0, 0}, 0);
+    CartCommunicator<2> slabs({world_size, 1}, {0, 0}, 0);
+    std::array<size_t, 2> global{2 * world_size + 1, 5};
+
+    auto value = [](size_t i, size_t j) { return float(100 * i + j) + 0.5f; };
+
+    DistributedArray<float, 2> out(blocks, global, 1);
+    auto ext = out.local_extents();
+    for (int i = 0; i < int(ext[0]); ++i){
+    for (int j = 0; j < int(ext[1]); ++j){
+        auto g = out.local_to_global({i, j});
+        out({i, j}) = value(g[0], g[1]);
+    }}
+
+    const std::string path = "mpi_wrapper_checkpoint_format_test.bin";
+    write_checkpoint(path, out);
+
+    //restart on another process grid
+    DistributedArray<float, 2> in(slabs, global);
+    auto header = read_checkpoint(path, in);
+    CHECK(header.n_dims == 2);
+    CHECK(header.element_size == sizeof(float));
+    CHECK(std::string(header.type_name) == "MPI_FLOAT");
+    CHECK(header.topology_dims[0] == n0);
+    CHECK(header.topology_dims[1] == world_size / n0);
+    auto in_ext = in.local_extents();
+    for (int i = 0; i < int(in_ext[0]); ++i){
+    for (int j = 0; j < int(in_ext[1]); ++j){
+        auto g = in.local_to_global({i, j});
+        CHECK(in({i, j}) == value(g[0], g[1]));
+    }}
+
+    //mismatching restarts are rejected on all ranks
+    DistributedArray<double, 2> wrong_type(slabs, global);
+    REQUIRE_THROWS(read_checkpoint(path, wrong_type));
+    DistributedArray<float, 2> wrong_extents(slabs, {global[0], global[1] + 1});
+    REQUIRE_THROWS(read_checkpoint(path, wrong_extents));
+
+    //serial access
+    if (blocks.get_rank() == 0){
+        MappedCheckpoint<float, 2> mapped(path);
+        CHECK(mapped.global_extents() == global);
+        CHECK(mapped({global[0] - 1, 3}) == value(global[0] - 1, 3));
+
+        std::vector<float> block(2 * 3);
+        mapped.read_block({1, 2}, {2, 3}, block.data());
+        for (size_t i = 0; i < 2; ++i){
+        for (size_t j = 0; j < 3; ++j){
+            CHECK(block[i * 3 + j] == value(1 + i, 2 + j));
+        }}
+
+        REQUIRE_THROWS(MappedCheckpoint<int, 2>(path));
+        REQUIRE_THROWS(MappedCheckpoint<float, 3>(path));
+        REQUIRE_THROWS(MappedCheckpoint<float, 2>("mpi_wrapper_missing_file.bin"));
+
+        //cut off the last element
+        auto size = off_t(CheckpointHeader::size_in_file + global[0] * global[1] * sizeof(float));
+        REQUIRE(truncate(path.c_str(), size - off_t(sizeof(float))) == 0);
+    }
+
+    //a truncated checkpoint is rejected instead of restarting with missing data
+    MPI_Barrier(MPI_COMM_WORLD);
+    DistributedArray<float, 2> truncated(blocks, global);
+    REQUIRE_THROWS_AS(read_checkpoint(path, truncated), std::runtime_error);
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (blocks.get_rank() == 0) { std::remove(path.c_str()); }
+
+}
+
+TEST_CASE("Compression"){
+
+    using namespace MpiWrapper::Utils;
+
+    std::minstd_rand random(3);
+    std::vector<unsigned char> noise(5000), runs(70000, 7), empty;
+    for (auto& b : noise) { b = uint8_t(random()); }
+    for (size_t i = 0; i < runs.size(); i += 301) { runs[i] = uint8_t(i); }
+
+    for (const auto* in : {&noise, &runs, &empty}){
+        std::vector<unsigned char> packed;
+        lz_compress(in->data(), in->size(), packed);
+        std::vector<unsigned char> out(in->size());
+        lz_decompress(packed.data(), packed.size(), out.data(), out.size());
+        CHECK(out == *in);
+    }
+
+    std::vector<unsigned char> packed;
+    lz_compress(runs.data(), runs.size(), packed);
+    CHECK(packed.size() * 20 < runs.size());
+
+    // A reused table must not leak matches from the previous message.
+    std::vector<size_t> table;
+    for (const auto* in : {&runs, &noise, &runs}) {
+        std::vector<unsigned char> repacked;
+        lz_compress(in->data(), in->size(), repacked, table);
+        std::vector<unsigned char> out(in->size());
+        lz_decompress(repacked.data(), repacked.size(), out.data(), out.size());
+        CHECK(out == *in);
+    }
+    std::vector<unsigned char> repacked;
+    lz_compress(runs.data(), runs.size(), repacked, table);
+    CHECK(repacked == packed);
+    std::vector<unsigned char> out(runs.size());
+    REQUIRE_THROWS(lz_decompress(packed.data(), packed.size() - 3, out.data(), out.size()));
+    REQUIRE_THROWS(lz_decompress(packed.data(), packed.size(), out.data(), out.size() - 1));
+
+    std::vector<double> values{0.0, 1.5, -2.25, 1e-7, 3.14159};
+    std::vector<unsigned char> shuffled(values.size() * sizeof(double));
+    std::vector<double> unshuffled(values.size());
+    auto bytes = reinterpret_cast<const unsigned char*>(values.data());
+    byte_shuffle(bytes, values.size(), 8, shuffled.data());
+    auto unshuffled_bytes = reinterpret_cast<unsigned char*>(unshuffled.data());
+    byte_unshuffle(shuffled.data(), values.size(), 8, unshuffled_bytes);
+    CHECK(unshuffled == values);
+
+    std::vector<uint64_t> q(values.size());
+    REQUIRE(quantize(values.data(), values.size(), 1e-3, q.data()));
+    dequantize(q.data(), q.size(), 1e-3, unshuffled.data());
+    for (size_t i = 0; i < values.size(); ++i){
+        CHECK(std::abs(unshuffled[i] - values[i]) <= 1e-3 * (1 + 1e-9));
+    }
+    values[2] = std::nan("");
+    CHECK(!quantize(values.data(), values.size(), 1e-3, q.data()));
+
+}
+
+TEST_CASE("CompressedTransport"){
+
+    using namespace MpiWrapper;
+
+    Communicator world;
+    const int rank = world.get_rank();
+    const int size = world.size();
+    const int next = (rank + 1) % size;
+    const int prev = (rank + size - 1) % size;
+
+    const size_t n = 20000;
+    auto smooth = [](int r, size_t i) { return 100.0 + r + std::sin(double(i) * 1e-3); };
+    std::vector<double> send(n), recv(n);
+
+    //lossless, the smooth field compresses
+    for (size_t i = 0; i < n; ++i) { send[i] = std::round(smooth(rank, i) * 256) / 256; }
+    CompressedTransport<double> lossless(world);
+    lossless.send_recv(send.data(), n, next, recv.data(), n, prev);
+    for (size_t i = 0; i < n; ++i) {
+        REQUIRE(recv[i] == std::round(smooth(prev, i) * 256) / 256);
+    }
+    CHECK(lossless.compressed_messages() == 1);
+    CHECK(lossless.ratio() > 1.25);
+
+    //noise does not pay off, the next messages are sent raw
+    std::mt19937_64 random(static_cast<unsigned>(rank));
+    std::vector<uint64_t> noise(n);
+    for (auto& v : noise) { v = random(); }
+    std::memcpy(send.data(), noise.data(), n * sizeof(double));
+    lossless.send_recv(send.data(), n, next, recv.data(), n, prev);
+    lossless.send_recv(send.data(), n, next, recv.data(), n, prev);
+    CHECK(lossless.compressed_messages() == 1);
+    std::mt19937_64 expected(static_cast<unsigned>(prev));
+    for (auto& v : noise) { v = expected(); }
+    CHECK(std::memcmp(recv.data(), noise.data(), n * sizeof(double)) == 0);
+
+    //small messages are never compressed
+    std::vector<int> small_send(100, rank), small_recv(100);
+    CompressedTransport<int> ints(world);
+    ints.send_recv(small_send.data(), 100, next, small_recv.data(), 100, prev);
+    CHECK(small_recv == std::vector<int>(100, prev));
+    CHECK(ints.compressed_messages() == 0);
+    CHECK(ints.sent_bytes() == ints.raw_bytes());
+
+    //lossy within the error bound
+    CompressionOptions options;
+    options.error_bound = 1e-4;
+    CompressedTransport<float> lossy(world, options);
+    std::vector<float> fsend(n), frecv(n);
+    for (size_t i = 0; i < n; ++i) { fsend[i] = float(smooth(rank, i)); }
+    if (size == 1) {
+        lossy.send_recv(fsend.data(), n, next, frecv.data(), n, prev);
+    } else if (rank == 0) {
+        lossy.send(fsend.data(), n, next);
+        lossy.recv(frecv.data(), n, MPI_ANY_SOURCE);
+    } else {
+        lossy.recv(frecv.data(), n, prev);
+        lossy.send(fsend.data(), n, next);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        REQUIRE(std::abs(double(frecv[i]) - double(float(smooth(prev, i)))) <= 1e-4 + 1e-5);
+    }
+    CHECK(lossy.compressed_messages() == 1);
+    CHECK(lossy.ratio() > 2.0);
+
+}
+
+TEST_CASE("BufferPool"){
+
+    using namespace MpiWrapper;
+
+    auto& pool = BufferPool::instance();
+
+    CHECK(BufferPool::size_class(1) == 0);
+    CHECK(BufferPool::size_class(256) == 0);
+    CHECK(BufferPool::size_class(257) == 1);
+    CHECK(BufferPool::capacity(BufferPool::size_class(100000)) >= 100000);
+    REQUIRE_THROWS(BufferPool::size_class(BufferPool::capacity(BufferPool::n_classes)));
+
+    //the steady state reuses the cached blocks
+    void* p = pool.allocate(5000);
+    CHECK(reinterpret_cast<uintptr_t>(p) % Utils::cache_line_size == 0);
+    std::memset(p, 1, 5000);
+    pool.deallocate(p);
+    size_t fresh = pool.fresh_allocations();
+    for (int i = 0; i < 10; ++i) {
+        void* q = pool.allocate(4097 + size_t(i));
+        CHECK(q == p);
+        pool.deallocate(q);
+    }
+    CHECK(pool.fresh_allocations() == fresh);
+    pool.deallocate(nullptr);
+
+    //more blocks than the thread cache holds go to the shared cache
+    std::vector<void*> blocks;
+    for (size_t i = 0; i < 2 * BufferPool::thread_cache_depth; ++i) {
+        blocks.push_back(pool.allocate(1000));
+    }
+    for (auto b : blocks) { pool.deallocate(b); }
+    CHECK(pool.cached_bytes() >= blocks.size() * BufferPool::capacity(2));
+    fresh = pool.fresh_allocations();
+    for (auto& b : blocks) { b = pool.allocate(1000); }
+    CHECK(pool.fresh_allocations() == fresh);
+    for (auto b : blocks) { pool.deallocate(b); }
+
+    PoolVector<double> v(1000);
+    std::iota(v.begin(), v.end(), 0.0);
+    v.resize(100000);
+    CHECK(v[999] == 999.0);
+    CHECK(reinterpret_cast<uintptr_t>(v.data()) % Utils::cache_line_size == 0);
+    v = PoolVector<double>();
+
+    pool.release();
+    CHECK(pool.cached_bytes() == 0);
+
+    //returned at exit, after MPI_Finalize, the block of MPI_Alloc_mem is dropped
+    static PoolVector<char> outlives_mpi(10000, 'x');
+    CHECK(outlives_mpi.back() == 'x');
+
+    //a halo exchange through the pooled buffers
+    size_t world_size = static_cast<size_t>(Mpi::world_size());
+    CartCommunicator<2> comm({world_size, 1}, {1, 1}, 0);
+    DistributedArray<int, 2> arr(comm, {4 * world_size, 6}, 1);
+    arr.set_halo_packing(HaloPacking::Engine);
+    arr({0, 0}) = 1;
+    arr.exchange_ghosts();
+    fresh = pool.fresh_allocations();
+    arr.exchange_ghosts();
+    CHECK(pool.fresh_allocations() == fresh);
+
+}
+
+TEST_CASE("Space-filling curves"){
+
+    using namespace MpiWrapper;
+
+    CHECK(Utils::morton_key<2>({1, 0}) == 2);
+    CHECK(Utils::morton_key<2>({0, 1}) == 1);
+    CHECK(Utils::morton_key<3>({1, 1, 1}) == 7);
+    CHECK(Utils::morton_key<2>({3, 3}) == 15);
+
+    //consecutive cells of the hilbert curve are face neighbours
+    auto check_hilbert_2d = [](uint32_t bits){
+        uint32_t n = 1u << bits;
+        std::vector<std::array<uint32_t, 2>> cells(n * n);
+        std::vector<bool> seen(n * n, false);
+        for (uint32_t i = 0; i < n; ++i){
+        for (uint32_t j = 0; j < n; ++j){
+            auto key = Utils::hilbert_key<2>({i, j}, bits);
+            REQUIRE(key < n * n);
+            REQUIRE(!seen[key]);
+            seen[key] = true;
+            cells[key] = {i, j};
+        }}
+        for (size_t k = 1; k < cells.size(); ++k){
+            auto d = std::abs(int(cells[k][0]) - int(cells[k - 1][0]))
+                   + std::abs(int(cells[k][1]) - int(cells[k - 1][1]));
+            CHECK(d == 1);
+        }
+    };
+    check_hilbert_2d(1);
+    check_hilbert_2d(4);
+
+    static_assert(Utils::max_curve_bits<1> == 32);
+    static_assert(Utils::max_curve_bits<2> == 32);
+    static_assert(Utils::max_curve_bits<3> == 21);
+    CHECK(Utils::hilbert_key<2>({0, 0}, 0) == 0);
+    CHECK(Utils::hilbert_key<1>({5}, 32) == 5);
+    REQUIRE_THROWS_AS(Utils::hilbert_key<1>({5}, 33), std::invalid_argument);
+    REQUIRE_THROWS_AS(Utils::hilbert_key<3>({1, 2, 3}, 22), std::invalid_argument);
+
+    uint32_t n = 8;
+    std::vector<std::array<uint32_t, 3>> coords;
+    for (uint32_t i = 0; i < n; ++i){
+    for (uint32_t j = 0; j < n; ++j){
+    for (uint32_t k = 0; k < n; ++k){
+        coords.push_back({i, j, k});
+    }}}
+    std::vector<uint64_t> keys(coords.size());
+    Utils::hilbert_keys(coords.data(), keys.data(), coords.size(), 3);
+    std::vector<std::array<uint32_t, 3>> cells(coords.size());
+    for (size_t i = 0; i < keys.size(); ++i) { cells[keys[i]] = coords[i]; }
+    for (size_t k = 1; k < cells.size(); ++k){
+        int d = 0;
+        for (size_t i = 0; i < 3; ++i) { d += std::abs(int(cells[k][i]) - int(cells[k - 1][i])); }
+        CHECK(d == 1);
+    }
+
+    Utils::morton_keys(coords.data(), keys.data(), coords.size());
+    std::sort(keys.begin(), keys.end());
+    CHECK(std::adjacent_find(keys.begin(), keys.end()) == keys.end());
+
+}
+
+TEST_CASE("sfc_partition"){
+
+    using namespace MpiWrapper;
+
+    Communicator comm;
+    int rank = comm.get_rank();
+    int size = comm.size();
+
+    //rank r holds 10 * (r + 1) consecutive keys, the first rank with heavy items
+    size_t n = size_t(10 * (rank + 1));
+    uint64_t first = 0;
+    for (int r = 0; r < rank; ++r) { first += uint64_t(10 * (r + 1)); }
+
+    std::vector<uint64_t> keys(n);
+    std::vector<double> weights(n, rank == 0 ? 3.0 : 1.0);
+    for (size_t i = 0; i < n; ++i) { keys[i] = 2 * (first + i); }
+
+    auto part = sfc_partition(comm, keys, weights);
+
+    REQUIRE(part.owners.size() == n);
+    REQUIRE(part.splitters.size() == size_t(size));
+    CHECK(std::is_sorted(part.owners.begin(), part.owners.end()));
+    CHECK(std::is_sorted(part.splitters.begin(), part.splitters.end()));
+
+    std::vector<double> load(size_t(size), 0.0);
+    for (size_t i = 0; i < n; ++i){
+        CHECK(part.owner_of(keys[i]) == part.owners[i]);
+        load[size_t(part.owners[i])] += weights[i];
+    }
+    MPI_Allreduce(MPI_IN_PLACE, load.data(), size, MPI_DOUBLE, MPI_SUM, comm.get_handle());
+
+    double total = std::accumulate(load.begin(), load.end(), 0.0);
+    for (auto l : load){
+        //at most one heavy item away from the ideal
+        CHECK(std::abs(l - total / size) <= 3.0);
+    }
+
+    //unit weights
+    auto unit = sfc_partition(comm, keys);
+    CHECK(std::is_sorted(unit.owners.begin(), unit.owners.end()));
+
+    //the order is checked on every rank
+    std::vector<uint64_t> unsorted(keys.rbegin(), keys.rend());
+    REQUIRE_THROWS_AS(sfc_partition(comm, rank == 0 ? unsorted : keys), std::runtime_error);
+    if (size > 1){
+        std::vector<uint64_t> reversed(n);
+        for (size_t i = 0; i < n; ++i) { reversed[i] = 1000000 - 2 * (first + n - i); }
+        REQUIRE_THROWS_AS(sfc_partition(comm, reversed), std::runtime_error);
+        std::vector<uint64_t> none;
+        REQUIRE_NOTHROW(sfc_partition(comm, rank == 1 ? none : keys));
+    }
+
+}
+
 TEST_CASE("Datatype tests"){
 
     using namespace MpiWrapper;
@@ -129,4 +1708,126 @@ TEST_CASE("Datatype tests"){
     REQUIRE_NOTHROW(MpiDatatype<void>());
     REQUIRE_NOTHROW(MpiDatatype<double>());
 
-}
\ No newline at end of file
+}
+
+
+TEST_CASE("RequestScheduler"){
+
+    using namespace MpiWrapper;
+
+    Communicator comm;
+    int rank = comm.get_rank();
+    int size = comm.size();
+
+    int right = (rank + 1) % size;
+    int left = (rank - 1 + size) % size;
+
+    std::vector<int> send(10, rank);
+    std::vector<int> recv(10, -1);
+
+    RequestScheduler scheduler;
+    int completed = 0;
+
+    scheduler.submit(comm.irecv(recv.data(), 10, MpiDatatype<int>(), left), [&](){ ++completed; });
+    scheduler.submit(comm.isend(send.data(), 10, MpiDatatype<int>(), right), [&](){ ++completed; });
+
+    //continuations can submit new requests, here a pending send/recv pair
+    int second = -1, third = -1;
+    scheduler.submit(comm.irecv(&second, 1, MpiDatatype<int>(), left, 2), [&](){ ++completed; });
+    scheduler.submit(comm.isend(&rank, 1, MpiDatatype<int>(), right, 2), [&](){
+        ++completed;
+        scheduler.submit(comm.irecv(&third, 1, MpiDatatype<int>(), left, 3), [&](){ ++completed; });
+        scheduler.submit(comm.isend(&rank, 1, MpiDatatype<int>(), right, 3), [&](){ ++completed; });
+    });
+
+    scheduler.run();
+
+    CHECK(scheduler.pending() == 0);
+    CHECK(completed == 6);
+    CHECK(second == left);
+    CHECK(third == left);
+    for (auto r : recv){
+        CHECK(r == left);
+    }
+
+}
+
+
+TEST_CASE("CommunicatorPool"){
+
+    using namespace MpiWrapper;
+
+    Communicator world;
+    CommunicatorHints hints;
+    hints.no_any_tag = true;
+
+    CommunicatorPool pool(world, 3, hints);
+    REQUIRE(pool.size() == 3);
+    REQUIRE_THROWS(pool[3]);
+
+    int rank = world.get_rank();
+    int size = world.size();
+
+    for (size_t i = 0; i < pool.size(); ++i){
+        CHECK(pool[i].size() == size);
+        CHECK(pool[i].get_rank() == rank);
+        CHECK(pool[i].get_handle() != world.get_handle());
+
+        int send = rank + int(i);
+        int recv = -1;
+        pool[i].send_recv(&send, 1, MpiDatatype<int>(), (rank + 1) % size,
+                          &recv, 1, MpiDatatype<int>(), (rank - 1 + size) % size);
+        CHECK(recv == (rank - 1 + size) % size + int(i));
+    }
+
+    CHECK(pool[0].get_handle() != pool[1].get_handle());
+
+    REQUIRE_NOTHROW(CommunicatorPool(world, 2));
+
+}
+
+
+TEST_CASE("TagAllocator and Channel"){
+
+    using namespace MpiWrapper;
+
+    Communicator world;
+    TagAllocator tags(world);
+
+    CHECK(tags.tag_ub() >= 32767);
+
+    auto r1 = tags.reserve(4);
+    auto r2 = tags.reserve(2);
+    CHECK(r1.count == 4);
+    CHECK(r2.first == r1.first + 4);
+    CHECK(!r1.contains(r2.first));
+    REQUIRE_THROWS(tags.reserve(tags.available() + 1));
+
+    Channel a = tags.channel();
+    Channel b = tags.channel(2);
+    CHECK(a.tag() != b.tag());
+    REQUIRE_THROWS(b.tag(2));
+
+    int rank = world.get_rank();
+    int size = world.size();
+    int right = (rank + 1) % size;
+    int left = (rank - 1 + size) % size;
+
+    //post the receives in the opposite order of the sends, the tags keep the exchanges apart
+    int ra = -1, rb = -1;
+    int sa = rank, sb = 100 + rank;
+    auto recv_b = b.irecv(&rb, 1, MpiDatatype<int>(), left, 1);
+    auto recv_a = a.irecv(&ra, 1, MpiDatatype<int>(), left);
+    auto send_a = a.isend(&sa, 1, MpiDatatype<int>(), right);
+    auto send_b = b.isend(&sb, 1, MpiDatatype<int>(), right, 1);
+
+    recv_a.wait();
+    recv_b.wait();
+    CHECK(ra == left);
+    CHECK(rb == 100 + left);
+
+    int rc = -1;
+    a.send_recv(&sa, 1, MpiDatatype<int>(), right, &rc, 1, MpiDatatype<int>(), left);
+    CHECK(rc == left);
+
+}